@@ -0,0 +1,21 @@
+#include "llvm/Support/Allocator.h"
+#include "ast-arena.h"
+#include "compile-context.h"
+#include <cstring>
+
+using namespace llvm;
+
+/* Copy the first length characters of the provided string into the arena of
+   the compilation unit, returning the null terminated copy. */
+char* copyToArena(CompileContext& context, const char* str, size_t length) {
+    char* copy = (char*) context.astArena.Allocate(length + 1, 1);
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/* Release all memory allocated in the arena of the compilation unit at once. No
+   AST node or parser list of the unit may be used afterwards. */
+void releaseAstArena(CompileContext& context) {
+    context.astArena.Reset();
+}
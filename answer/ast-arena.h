@@ -0,0 +1,61 @@
+#ifndef AST_ARENA_H
+#define AST_ARENA_H
+
+#include "llvm/Support/AlignOf.h"
+#include "llvm/Support/Allocator.h"
+#include <cstddef>
+#include <new>
+
+using namespace llvm;
+
+struct CompileContext;
+
+char* copyToArena(CompileContext& context, const char* str, size_t length);
+void releaseAstArena(CompileContext& context);
+
+// ArenaAllocator - Standard allocator that takes its memory from the AST arena of a
+// compilation unit, used for the lists built by the parser. Memory is only
+// reclaimed by releaseAstArena().
+template <typename T>
+class ArenaAllocator {
+    BumpPtrAllocator* arena;
+
+    template <typename U>
+    friend class ArenaAllocator;
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <typename U>
+    struct rebind {
+        typedef ArenaAllocator<U> other;
+    };
+
+    ArenaAllocator(BumpPtrAllocator& astArena) : arena(&astArena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    pointer allocate(size_type count, const void* hint = 0) {
+        return (pointer) arena->Allocate(count * sizeof(T), AlignOf<T>::Alignment);
+    }
+    void deallocate(pointer ptr, size_type count) {}
+
+    void construct(pointer ptr, const T& value) { new ((void*) ptr) T(value); }
+    void destroy(pointer ptr) { ptr->~T(); }
+
+    pointer address(reference value) const { return &value; }
+    const_pointer address(const_reference value) const { return &value; }
+    size_type max_size() const { return ((size_type) -1) / sizeof(T); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpander.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "bounds-check.h"
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+const char* BOUNDS_CHECK_METADATA = "decaf.boundscheck";
+
+namespace {
+
+// BoundsCheckHoisting - Hoists the -fbounds-check range checks of affine loop
+// indexes into the loop preheader.
+//
+// For an index {start,+,step} of a loop with a computable trip count, the
+// first and last index are checked once in the preheader, using 64-bit
+// arithmetic so that the check also fails if the 32-bit index would wrap. The
+// in-loop condition then becomes "hoisted || check", which is loop invariantly
+// true when the whole range is in bounds. Loop unswitching turns that into a
+// check free version of the loop, while the original version keeps trapping
+// on the exact iteration that goes out of bounds.
+class BoundsCheckHoisting : public FunctionPass {
+    ScalarEvolution* scalarEvolution;
+    DominatorTree* dominatorTree;
+
+    bool hoistLoopChecks(Loop* loop);
+    const SCEV* getBackedgeBound(Loop* loop);
+    Value* createRangeCheck(Loop* loop, const SCEVAddRecExpr* index, ConstantInt* size, SCEVExpander& expander);
+public:
+    static char ID;
+    BoundsCheckHoisting() : FunctionPass(ID) {}
+
+    virtual bool runOnFunction(Function& function);
+    virtual void getAnalysisUsage(AnalysisUsage& usage) const;
+};
+
+}
+
+char BoundsCheckHoisting::ID = 0;
+
+void BoundsCheckHoisting::getAnalysisUsage(AnalysisUsage& usage) const {
+    usage.addRequired<DominatorTree>();
+    usage.addRequired<LoopInfo>();
+    usage.addRequired<ScalarEvolution>();
+}
+
+bool BoundsCheckHoisting::runOnFunction(Function& function) {
+    LoopInfo& loopInfo = getAnalysis<LoopInfo>();
+    scalarEvolution = &getAnalysis<ScalarEvolution>();
+    dominatorTree = &getAnalysis<DominatorTree>();
+
+    // Visit inner loops before the loops containing them.
+    vector<Loop*> worklist(loopInfo.begin(), loopInfo.end());
+    vector<Loop*> loops;
+    while (!worklist.empty()) {
+        Loop* loop = worklist.back();
+        worklist.pop_back();
+        loops.push_back(loop);
+        worklist.insert(worklist.end(), loop->begin(), loop->end());
+    }
+
+    bool changed = false;
+    for (vector<Loop*>::reverse_iterator it = loops.rbegin(); it != loops.rend(); it++) {
+        changed |= hoistLoopChecks(*it);
+    }
+
+    return changed;
+}
+
+/* Return true if the instruction is a branch emitted by checkArrayIndex. */
+static bool isBoundsCheck(Instruction* instruction) {
+    BranchInst* branch = dyn_cast<BranchInst>(instruction);
+    return (branch != NULL && branch->isConditional() && branch->getMetadata(BOUNDS_CHECK_METADATA) != NULL);
+}
+
+/* Return an upper bound of the number of times the loop backedge is taken, or
+   NULL if there is none. The bounds checks themselves exit the loop (to the
+   trap block) and must not bound it, and only exits that run on every
+   iteration, i.e. that dominate the latch, are guaranteed to be taken. */
+const SCEV* BoundsCheckHoisting::getBackedgeBound(Loop* loop) {
+    BasicBlock* latch = loop->getLoopLatch();
+    if (latch == NULL) {
+        return NULL;
+    }
+
+    SmallVector<BasicBlock*, 4> exitingBlocks;
+    loop->getExitingBlocks(exitingBlocks);
+
+    const SCEV* bound = NULL;
+    for (unsigned i = 0; i < exitingBlocks.size(); i++) {
+        BasicBlock* exitingBlock = exitingBlocks[i];
+        if (isBoundsCheck(exitingBlock->getTerminator()) || !dominatorTree->dominates(exitingBlock, latch)) {
+            continue;
+        }
+
+        const SCEV* count = scalarEvolution->getExitCount(loop, exitingBlock);
+        if (!isa<SCEVCouldNotCompute>(count)) {
+            bound = (bound == NULL ? count : scalarEvolution->getUMinFromMismatchedTypes(bound, count));
+        }
+    }
+
+    return bound;
+}
+
+/* Return the condition "first and last index of the loop are below the array
+   size", expanded in the preheader, or NULL if the range is not computable. */
+Value* BoundsCheckHoisting::createRangeCheck(Loop* loop, const SCEVAddRecExpr* index, ConstantInt* size,
+                                             SCEVExpander& expander) {
+    const SCEV* backedgeCount = getBackedgeBound(loop);
+    if (backedgeCount == NULL || !index->isAffine()) {
+        return NULL;
+    }
+
+    Type* wideType = Type::getInt64Ty(loop->getHeader()->getContext());
+    const SCEV* start = scalarEvolution->getSignExtendExpr(index->getStart(), wideType);
+    const SCEV* step = scalarEvolution->getSignExtendExpr(index->getStepRecurrence(*scalarEvolution), wideType);
+    const SCEV* count = scalarEvolution->getZeroExtendExpr(backedgeCount, wideType);
+    const SCEV* last = scalarEvolution->getAddExpr(start, scalarEvolution->getMulExpr(step, count));
+    if (!scalarEvolution->isLoopInvariant(start, loop) || !scalarEvolution->isLoopInvariant(last, loop)) {
+        return NULL;
+    }
+
+    Instruction* insertPoint = loop->getLoopPreheader()->getTerminator();
+    IRBuilder<> builder(insertPoint);
+    Value* wideSize = ConstantInt::get(wideType, size->getZExtValue());
+    Value* firstInBounds = builder.CreateICmpULT(expander.expandCodeFor(start, wideType, insertPoint), wideSize);
+    Value* lastInBounds = builder.CreateICmpULT(expander.expandCodeFor(last, wideType, insertPoint), wideSize);
+
+    return builder.CreateAnd(firstInBounds, lastInBounds, "rangeinbounds");
+}
+
+/* Hoist the checks of the loop whose index is an affine recurrence of the loop.
+   Loops without a preheader (LoopSimplify did not run first) are left alone. */
+bool BoundsCheckHoisting::hoistLoopChecks(Loop* loop) {
+    if (loop->getLoopPreheader() == NULL) {
+        return false;
+    }
+
+    SCEVExpander expander(*scalarEvolution, "boundscheck");
+    bool changed = false;
+
+    for (Loop::block_iterator blockIt = loop->block_begin(); blockIt != loop->block_end(); blockIt++) {
+        if (!isBoundsCheck((*blockIt)->getTerminator())) {
+            continue;
+        }
+        BranchInst* check = cast<BranchInst>((*blockIt)->getTerminator());
+
+        // Only the "index u< size" form emitted by checkArrayIndex is handled,
+        // other passes may already have folded or rewritten the condition. This
+        // also skips checks already hoisted out of an inner loop.
+        ICmpInst* compare = dyn_cast<ICmpInst>(check->getCondition());
+        if (compare == NULL || compare->getPredicate() != ICmpInst::ICMP_ULT) {
+            continue;
+        }
+        ConstantInt* size = dyn_cast<ConstantInt>(compare->getOperand(1));
+        const SCEVAddRecExpr* index = dyn_cast<SCEVAddRecExpr>(scalarEvolution->getSCEV(compare->getOperand(0)));
+        if (size == NULL || index == NULL || index->getLoop() != loop) {
+            continue;
+        }
+
+        Value* rangeInBounds = createRangeCheck(loop, index, size, expander);
+        if (rangeInBounds == NULL) {
+            continue;
+        }
+
+        IRBuilder<> builder(check);
+        check->setCondition(builder.CreateOr(rangeInBounds, compare, "inbounds"));
+        changed = true;
+    }
+
+    return changed;
+}
+
+/* Create the pass hoisting bounds checks out of loops, see BoundsCheckHoisting. */
+FunctionPass* createBoundsCheckHoistingPass() {
+    return new BoundsCheckHoisting();
+}
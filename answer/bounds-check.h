@@ -0,0 +1,12 @@
+#ifndef BOUNDS_CHECK_H
+#define BOUNDS_CHECK_H
+
+#include "llvm/Pass.h"
+
+using namespace llvm;
+
+extern const char* BOUNDS_CHECK_METADATA;
+
+FunctionPass* createBoundsCheckHoistingPass();
+
+#endif
@@ -0,0 +1,42 @@
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "compile-context.h"
+#include "debug-info.h"
+#include "llvm-pass.h"
+#include "llvm-target.h"
+#include "llvm-util.h"
+#include "ssa-construction.h"
+
+using namespace llvm;
+
+/* Create the state for a new compilation unit, with an empty module and the
+   pass managers selected by the compile options. */
+CompileContext::CompileContext() : builder(llvmContext) {
+    linePos = 1;
+    scopeDepth = 0;
+    trapBlock = NULL;
+    functionPassManager = NULL;
+    modulePassManager = NULL;
+    debugBuilder = NULL;
+    debugFile = NULL;
+    debugScope = NULL;
+
+    // Types are owned by the LLVM context, so they only need to be resolved once.
+    typeTable[TYPE_VOID] = builder.getVoidTy();
+    typeTable[TYPE_INT] = builder.getInt32Ty();
+    typeTable[TYPE_BOOL] = builder.getInt1Ty();
+    typeTable[TYPE_STRING] = builder.getInt8PtrTy();
+
+    module = new Module(MODULE_NAME, llvmContext);
+    configureModule(module);
+    initializePassManagers(*this);
+    initializeDebugInfo(*this);
+}
+
+/* Release the unit, the pass managers must be deleted before their module. */
+CompileContext::~CompileContext() {
+    releaseLocalVariables(*this);
+    releasePassManagers(*this);
+    delete debugBuilder;
+    delete module;
+}
@@ -0,0 +1,84 @@
+#ifndef COMPILE_CONTEXT_H
+#define COMPILE_CONTEXT_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/DIBuilder.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/ValueHandle.h"
+#include "symbol-table.h"
+#include "value-constants.h"
+#include <deque>
+#include <utility>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+class FunctionExprAst;
+
+// Phis placed in a block before all of its predecessors were known, with their variable.
+typedef vector<pair<AllocaInst*, PHINode*> > IncompletePhiList;
+
+// CompileContext - The state of a single compilation unit, from the scanner
+// position to the module and pass managers. The target machine, profile counts,
+// recoverable errors and compile statistics are still process wide, so only one
+// unit is compiled at a time. The context is passed explicitly through parsing
+// and codegen.
+struct CompileContext {
+    // Scanner (see decaf-codegen.lex), the line number is kept by the scanner itself.
+    int linePos;
+
+    // AST nodes, parser lists and string constants (see ast-arena.cpp).
+    BumpPtrAllocator astArena;
+    // Methods whose bodies are generated once the whole class is declared.
+    deque<FunctionExprAst*> functionList;
+
+    // Symbol tables (see symbol-table.cpp).
+    StringMap<char> identifierTable;
+    SymbolTable symbolTable;
+    ScopeVector scopeStack;
+    int scopeDepth;
+
+    // Targets of continue and break statements in the enclosing loops.
+    vector<BasicBlock*> continueBlocks;
+    vector<BasicBlock*> breakBlocks;
+
+    // Direct SSA construction of the locals of the current method (see ssa-construction.cpp).
+    vector<AllocaInst*> localVariables;
+    DenseMap<pair<AllocaInst*, BasicBlock*>, WeakVH> currentDefs;
+    SmallPtrSet<BasicBlock*, 32> sealedBlocks;
+    DenseMap<BasicBlock*, IncompletePhiList> incompletePhis;
+
+    // Code generation (see llvm-util.cpp), llvmContext must outlive the others.
+    LLVMContext llvmContext;
+    Module* module;
+    IRBuilder<> builder;
+    Type* typeTable[TYPE_COUNT];
+    BasicBlock* trapBlock;
+
+    // Debug info (see debug-info.cpp), NULL unless -g. The scope is the method being generated.
+    DIBuilder* debugBuilder;
+    MDNode* debugFile;
+    MDNode* debugScope;
+
+    // Optimization (see llvm-pass.cpp), NULL when disabled.
+    FunctionPassManager* functionPassManager;
+    PassManager* modulePassManager;
+
+    CompileContext();
+    ~CompileContext();
+
+private:
+    CompileContext(const CompileContext&);
+    CompileContext& operator=(const CompileContext&);
+};
+
+#endif
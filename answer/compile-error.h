@@ -0,0 +1,17 @@
+#ifndef COMPILE_ERROR_H
+#define COMPILE_ERROR_H
+
+#include <stdexcept>
+
+// CompileError - Raised by throwError instead of exiting the program when errors
+// are recoverable, so that a single process can compile many units.
+class CompileError : public std::runtime_error {
+    int code;
+public:
+    CompileError(const char* errorMsg, int errorCode) : std::runtime_error(errorMsg), code(errorCode) {}
+    int getCode() const { return code; }
+};
+
+void setRecoverableErrors(bool recoverable);
+
+#endif
@@ -0,0 +1,269 @@
+#include "compile-options.h"
+#include "value-constants.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+const char* OPTION_RUN = "--run";
+const char* OPTION_SERVER = "--server";
+const char* OPTION_EMIT_BITCODE = "-emit-bc";
+const char* OPTION_EMIT_OBJECT = "-emit-obj";
+const char* OPTION_OUTPUT_FILE = "-o";
+const char* OPTION_OPT_LEVEL = "-O";
+const char* OPTION_INLINE_THRESHOLD = "-inline-threshold=";
+const char* OPTION_JOBS = "-jobs=";
+const char* OPTION_TIME_REPORT = "-time-report";
+const char* OPTION_BOUNDS_CHECK = "-fbounds-check";
+const char* OPTION_TIME_REPORT_JSON = "-time-report=json";
+const char* OPTION_CACHE_DIR = "-cache-dir=";
+const char* OPTION_TARGET_CPU = "-mcpu=";
+const char* OPTION_NO_VECTORIZE = "-fno-vectorize";
+const char* OPTION_NO_DIRECT_SSA = "-fno-direct-ssa";
+const char* OPTION_WHOLE_PROGRAM = "-fwhole-program";
+const char* OPTION_PROFILE_GENERATE = "-fprofile-generate";
+const char* OPTION_PROFILE_USE = "-fprofile-use";
+const char* OPTION_INSTRUMENT_METHODS = "-finstrument-methods";
+const char* OPTION_DEBUG_INFO = "-g";
+const char* OPTION_SOURCE_NAME = "-source-name=";
+const char* VALUE_NATIVE_CPU = "native";
+
+const char* DEFAULT_BITCODE_FILE = "decaf.bc";
+const char* DEFAULT_OBJECT_FILE = "decaf.o";
+const char* DEFAULT_PROFILE_FILE = "decaf.profile";
+const char* DEFAULT_SOURCE_NAME = "<stdin>";
+const int DEFAULT_OPT_LEVEL = 1;
+const int MAX_OPT_LEVEL = 3;
+const int DEFAULT_INLINE_THRESHOLD = 225;
+
+static OutputMode outputMode = OUTPUT_IR;
+static bool serverMode = false;
+static const char* outputFile = NULL;
+static int optLevel = DEFAULT_OPT_LEVEL;
+static int inlineThreshold = DEFAULT_INLINE_THRESHOLD;
+static int jobCount = 1;
+static TimeReport timeReport = TIME_REPORT_NONE;
+static bool boundsCheck = false;
+static const char* cacheDirectory = NULL;
+static const char* targetCPU = NULL;
+static bool vectorize = true;
+static bool directSsa = true;
+static bool wholeProgram = false;
+static ProfileMode profileMode = PROFILE_NONE;
+static const char* profileFile = NULL;
+static bool instrumentMethods = false;
+static bool debugInfo = false;
+static const char* sourceName = NULL;
+
+/* Return true if the option is an optimization level (-O0 to -O3). */
+static bool isOptLevelOption(const char* option) {
+    size_t prefixLength = strlen(OPTION_OPT_LEVEL);
+    if (strncmp(option, OPTION_OPT_LEVEL, prefixLength) != 0 || strlen(option) != prefixLength + 1) {
+        return false;
+    }
+
+    char level = option[prefixLength];
+    return ('0' <= level && level <= '0' + MAX_OPT_LEVEL);
+}
+
+/* Parse the value of an option as a non-negative decimal integer, returning
+   false if it is anything else. */
+static bool parseIntegerValue(const char* text, int& value) {
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+
+    char* end;
+    long parsed = strtol(text, &end, 10);
+    if (*end != '\0' || parsed > INT_MAX) {
+        return false;
+    }
+
+    value = (int) parsed;
+    return true;
+}
+
+/* Return true if the option is the provided profile option, alone or with a
+   file (OPTION=FILE), storing the file if one was given. */
+static bool isProfileOption(const char* option, const char* profileOption) {
+    size_t prefixLength = strlen(profileOption);
+    if (strncmp(option, profileOption, prefixLength) != 0) {
+        return false;
+    } else if (option[prefixLength] == '\0') {
+        return true;
+    } else if (option[prefixLength] == '=' && option[prefixLength + 1] != '\0') {
+        profileFile = option + prefixLength + 1;
+        return true;
+    }
+
+    return false;
+}
+
+/* Parse the command line arguments provided to the driver. Unknown options
+   halt the program with a failed status. */
+void parseCompileOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        char* option = argv[i];
+
+        if (strcmp(option, OPTION_RUN) == 0) {
+            outputMode = OUTPUT_RUN;
+        } else if (strcmp(option, OPTION_SERVER) == 0) {
+            serverMode = true;
+        } else if (strcmp(option, OPTION_EMIT_BITCODE) == 0) {
+            outputMode = OUTPUT_BITCODE;
+        } else if (strcmp(option, OPTION_EMIT_OBJECT) == 0) {
+            outputMode = OUTPUT_OBJECT;
+        } else if (strcmp(option, OPTION_OUTPUT_FILE) == 0 && i + 1 < argc) {
+            i++;
+            outputFile = argv[i];
+        } else if (strncmp(option, OPTION_INLINE_THRESHOLD, strlen(OPTION_INLINE_THRESHOLD)) == 0) {
+            if (!parseIntegerValue(option + strlen(OPTION_INLINE_THRESHOLD), inlineThreshold)) {
+                fprintf(stderr, "%s: ", option);
+                throwError(ERROR_INVALID_OPTION_VALUE, EXIT_ERROR);
+            }
+        } else if (strncmp(option, OPTION_JOBS, strlen(OPTION_JOBS)) == 0) {
+            jobCount = atoi(option + strlen(OPTION_JOBS));
+            jobCount = (jobCount < 1 ? 1 : jobCount);
+        } else if (strncmp(option, OPTION_CACHE_DIR, strlen(OPTION_CACHE_DIR)) == 0) {
+            cacheDirectory = option + strlen(OPTION_CACHE_DIR);
+            cacheDirectory = (*cacheDirectory == '\0' ? NULL : cacheDirectory);
+        } else if (strncmp(option, OPTION_TARGET_CPU, strlen(OPTION_TARGET_CPU)) == 0) {
+            targetCPU = option + strlen(OPTION_TARGET_CPU);
+            targetCPU = (strcmp(targetCPU, VALUE_NATIVE_CPU) == 0 ? NULL : targetCPU);
+        } else if (strcmp(option, OPTION_NO_VECTORIZE) == 0) {
+            vectorize = false;
+        } else if (strcmp(option, OPTION_NO_DIRECT_SSA) == 0) {
+            directSsa = false;
+        } else if (strcmp(option, OPTION_WHOLE_PROGRAM) == 0) {
+            wholeProgram = true;
+        } else if (isProfileOption(option, OPTION_PROFILE_GENERATE)) {
+            profileMode = PROFILE_GENERATE;
+        } else if (isProfileOption(option, OPTION_PROFILE_USE)) {
+            profileMode = PROFILE_USE;
+        } else if (strcmp(option, OPTION_INSTRUMENT_METHODS) == 0) {
+            instrumentMethods = true;
+        } else if (strcmp(option, OPTION_DEBUG_INFO) == 0) {
+            debugInfo = true;
+        } else if (strncmp(option, OPTION_SOURCE_NAME, strlen(OPTION_SOURCE_NAME)) == 0) {
+            sourceName = option + strlen(OPTION_SOURCE_NAME);
+            sourceName = (*sourceName == '\0' ? NULL : sourceName);
+        } else if (strcmp(option, OPTION_BOUNDS_CHECK) == 0) {
+            boundsCheck = true;
+        } else if (strcmp(option, OPTION_TIME_REPORT) == 0) {
+            timeReport = TIME_REPORT_TEXT;
+        } else if (strcmp(option, OPTION_TIME_REPORT_JSON) == 0) {
+            timeReport = TIME_REPORT_JSON;
+        } else if (isOptLevelOption(option)) {
+            optLevel = option[strlen(OPTION_OPT_LEVEL)] - '0';
+        } else {
+            fprintf(stderr, "%s: ", option);
+            throwError(ERROR_UNKNOWN_OPTION, EXIT_ERROR);
+        }
+    }
+}
+
+/* Return what should be done with the generated module. */
+OutputMode getOutputMode() {
+    return outputMode;
+}
+
+/* Return true if the driver should serve compile requests instead of
+   compiling a single program. */
+bool isServerMode() {
+    return serverMode;
+}
+
+/* Return the file that bitcode or object output is written to. */
+const char* getOutputFile() {
+    if (outputFile != NULL) {
+        return outputFile;
+    }
+
+    return (outputMode == OUTPUT_OBJECT ? DEFAULT_OBJECT_FILE : DEFAULT_BITCODE_FILE);
+}
+
+/* Return the optimization level, where 0 disables all passes, 1 runs the
+   function passes and inlines small methods (default) and 2-3 run the full
+   module pipeline. */
+int getOptimizationLevel() {
+    return optLevel;
+}
+
+/* Return the cost below which the inliner inlines a call site. */
+int getInlineThreshold() {
+    return inlineThreshold;
+}
+
+/* Return the number of worker processes that generate method bodies. */
+int getJobCount() {
+    return jobCount;
+}
+
+/* Return the format of the compile time report, if one was requested. */
+TimeReport getTimeReport() {
+    return timeReport;
+}
+
+/* Return true if array indexes are checked against the array bounds. */
+bool isBoundsCheckEnabled() {
+    return boundsCheck;
+}
+
+/* Return the directory of the per method compile cache, or NULL if methods
+   are always compiled from scratch. */
+const char* getCacheDirectory() {
+    return cacheDirectory;
+}
+
+/* Return the processor that code is optimized and compiled for, or NULL for
+   the host processor and its detected features (-mcpu=native, default). */
+const char* getTargetCPU() {
+    return targetCPU;
+}
+
+/* Return true if the loop and SLP vectorizers run (-O2 and up). */
+bool isVectorizeEnabled() {
+    return vectorize && optLevel >= 2;
+}
+
+/* Return true if locals are kept in SSA values during code generation (default),
+   rather than in allocas promoted by mem2reg. */
+bool isDirectSsaEnabled() {
+    return directSsa;
+}
+
+/* Return true if the module is the whole program, so that everything except main
+   and the externs may be internalized and optimized as such (-O1 and up). */
+bool isWholeProgramEnabled() {
+    return wholeProgram && optLevel >= 1;
+}
+
+/* Return whether the methods count their branches and calls or are optimized
+   with counts from an earlier run. */
+ProfileMode getProfileMode() {
+    return profileMode;
+}
+
+/* Return the file the counts are written to (-fprofile-generate) or read
+   from (-fprofile-use). */
+const char* getProfileFile() {
+    return (profileFile != NULL ? profileFile : DEFAULT_PROFILE_FILE);
+}
+
+/* Return true if every method calls the profiler hooks of the runtime on entry
+   and exit, which print the time spent per method at exit. */
+bool isMethodInstrumentationEnabled() {
+    return instrumentMethods;
+}
+
+/* Return true if the module carries DWARF line tables mapping the generated
+   code back to the lines and columns of the source (-g). */
+bool isDebugInfoEnabled() {
+    return debugInfo;
+}
+
+/* Return the file name the debug info gives the source, which is read from
+   standard input. */
+const char* getSourceName() {
+    return (sourceName != NULL ? sourceName : DEFAULT_SOURCE_NAME);
+}
@@ -0,0 +1,46 @@
+#ifndef COMPILE_OPTIONS_H
+#define COMPILE_OPTIONS_H
+
+// OutputMode - What the driver does with the generated module.
+enum OutputMode {
+    OUTPUT_IR,      // Print the textual IR to standard error (default).
+    OUTPUT_RUN,     // JIT compile the module and call the Decaf main.
+    OUTPUT_BITCODE, // Write LLVM bitcode to the output file.
+    OUTPUT_OBJECT   // Write a native object to the output file.
+};
+
+// ProfileMode - Profile guided optimization, instrumenting or using counts.
+enum ProfileMode {
+    PROFILE_NONE,
+    PROFILE_GENERATE, // Count method entries and branch edges, written at exit.
+    PROFILE_USE       // Weigh branches and methods with the counts of a profile.
+};
+
+// TimeReport - Format of the -time-report statistics, if any.
+enum TimeReport {
+    TIME_REPORT_NONE,
+    TIME_REPORT_TEXT,
+    TIME_REPORT_JSON
+};
+
+void parseCompileOptions(int argc, char** argv);
+OutputMode getOutputMode();
+bool isServerMode();
+const char* getOutputFile();
+int getOptimizationLevel();
+int getInlineThreshold();
+int getJobCount();
+TimeReport getTimeReport();
+bool isBoundsCheckEnabled();
+const char* getCacheDirectory();
+const char* getTargetCPU();
+bool isVectorizeEnabled();
+bool isDirectSsaEnabled();
+bool isWholeProgramEnabled();
+ProfileMode getProfileMode();
+const char* getProfileFile();
+bool isMethodInstrumentationEnabled();
+bool isDebugInfoEnabled();
+const char* getSourceName();
+
+#endif
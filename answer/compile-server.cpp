@@ -0,0 +1,78 @@
+#include "llvm/IR/Module.h"
+#include "llvm/Support/raw_ostream.h"
+#include "compile-context.h"
+#include "compile-error.h"
+#include "compile-server.h"
+#include "exprdefs.h"
+#include "llvm-util.h"
+#include "value-constants.h"
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+/* Read the next request, "<length>\n" followed by length bytes of Decaf
+   source. Returns false once the input is exhausted or malformed. */
+static bool readRequest(FILE* input, vector<char>& source) {
+    int length;
+    if (fscanf(input, "%d", &length) != 1) {
+        return false;
+    }
+    if (length < 0 || fgetc(input) != '\n') {
+        fprintf(stderr, "%s", ERROR_BAD_REQUEST);
+        return false;
+    }
+
+    source.resize(length + 1);
+    if (fread(&source[0], 1, length, input) != (size_t) length) {
+        fprintf(stderr, "%s", ERROR_BAD_REQUEST);
+        return false;
+    }
+    source[length] = '\0';
+
+    return true;
+}
+
+/* Write a response, "<status> <length>\n" followed by length bytes holding the
+   textual IR on success or the error message on failure. */
+static void writeResponse(FILE* output, int status, const string& payload) {
+    fprintf(output, "%d %lu\n", status, (unsigned long) payload.size());
+    fwrite(payload.data(), 1, payload.size(), output);
+    fflush(output);
+}
+
+/* Serve compile requests from the input until it is closed, answering each on
+   the output. LLVM is initialized once by the driver and each request gets a
+   fresh compile context, which avoids the process startup cost per file. */
+int runCompileServer(FILE* input, FILE* output) {
+    setRecoverableErrors(true);
+
+    vector<char> source;
+    while (readRequest(input, source)) {
+        int status = EXIT_NO_ERROR;
+        string payload;
+
+        try {
+            CompileContext context;
+            compileSource(context, &source[0], source.size() - 1);
+
+            raw_string_ostream irStream(payload);
+            context.module->print(irStream, NULL);
+            irStream.flush();
+        } catch (CompileError& error) {
+            status = error.getCode();
+            payload = error.what();
+        } catch (exception& error) {
+            status = EXIT_ERROR;
+            payload = error.what();
+        }
+
+        writeResponse(output, status, payload);
+    }
+
+    return EXIT_NO_ERROR;
+}
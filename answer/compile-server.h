@@ -0,0 +1,8 @@
+#ifndef COMPILE_SERVER_H
+#define COMPILE_SERVER_H
+
+#include <cstdio>
+
+int runCompileServer(FILE* input, FILE* output);
+
+#endif
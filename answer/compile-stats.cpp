@@ -0,0 +1,289 @@
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "compile-options.h"
+#include "compile-stats.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+const char* PHASE_NAMES[PHASE_COUNT] = {
+    "lex", "parse", "declarations", "bodies", "function passes", "module passes", "output"
+};
+
+// FunctionStats - Time spent generating and optimizing a method, and the size
+// of its code before optimization.
+struct FunctionStats {
+    string name;
+    CompileTime time;
+    unsigned blocks;
+    unsigned instructions;
+};
+
+// PassTime - Wall clock time spent in an LLVM pass.
+struct PassTime {
+    string name;
+    double wall;
+};
+
+// Only one in every LEX_SAMPLE_INTERVAL tokens is timed, as reading the clocks
+// costs more than scanning a token.
+const unsigned LEX_SAMPLE_INTERVAL = 64;
+
+static CompileTime phaseTimes[PHASE_COUNT];
+static vector<CompilePhase> phaseStack;
+static CompileTime phaseStart;
+
+static vector<FunctionStats> functionStats;
+static FunctionStats pendingFunction;
+static unsigned tokenCount = 0;
+static unsigned astNodeCount = 0;
+static unsigned blockCount = 0;
+static unsigned instructionCount = 0;
+
+/* Return the number of instructions in the provided function. */
+static unsigned countInstructions(Function* function) {
+    unsigned count = 0;
+    for (Function::iterator it = function->begin(); it != function->end(); it++) {
+        count += it->size();
+    }
+
+    return count;
+}
+
+/* Add the time elapsed since the phase on top of the stack was (re)started to
+   that phase, and restart the clock. */
+static void chargeCurrentPhase() {
+    CompileTime now = getCompileTime();
+    if (!phaseStack.empty()) {
+        CompileTime& phaseTime = phaseTimes[phaseStack.back()];
+        phaseTime.wall += now.wall - phaseStart.wall;
+        phaseTime.cpu += now.cpu - phaseStart.cpu;
+        // For phases, peakRss holds how much the peak grew while they ran.
+        phaseTime.peakRss += now.peakRss - phaseStart.peakRss;
+    }
+
+    phaseStart = now;
+}
+
+/* Collect the per pass timings of LLVM (TimePassesIsEnabled) from its timer
+   report, in which every pass is a line of "<seconds> (<percent>%)" columns
+   ending with the wall time, followed by the pass name. */
+static vector<PassTime> collectPassTimes() {
+    string report;
+    raw_string_ostream reportStream(report);
+    TimerGroup::printAll(reportStream);
+    reportStream.flush();
+
+    vector<PassTime> passTimes;
+    size_t lineStart = 0;
+    while (lineStart < report.size()) {
+        size_t lineEnd = report.find('\n', lineStart);
+        lineEnd = (lineEnd == string::npos ? report.size() : lineEnd);
+        string line = report.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        // Headers and totals have no percentage or are named Total.
+        size_t columnsEnd = line.rfind("%)");
+        size_t wallEnd = line.rfind('(', columnsEnd);
+        size_t nameStart = line.find_first_not_of(' ', columnsEnd + 2);
+        if (columnsEnd == string::npos || wallEnd == string::npos || nameStart == string::npos) {
+            continue;
+        }
+        size_t wallStart = line.find_last_of(' ', line.find_last_not_of(' ', wallEnd - 1));
+
+        PassTime passTime;
+        passTime.name = line.substr(nameStart);
+        passTime.wall = atof(line.c_str() + (wallStart == string::npos ? 0 : wallStart + 1));
+        if (passTime.name != "Total") {
+            passTimes.push_back(passTime);
+        }
+    }
+
+    return passTimes;
+}
+
+/* Return true if -time-report was given, all other functions do nothing otherwise. */
+bool isTimeReportEnabled() {
+    return (getTimeReport() != TIME_REPORT_NONE);
+}
+
+/* Return the current wall clock time and the CPU time used by the process. */
+CompileTime getCompileTime() {
+    CompileTime time = { 0.0, 0.0, 0 };
+    if (!isTimeReportEnabled()) {
+        return time;
+    }
+
+    struct timeval wallTime;
+    struct rusage usage;
+    gettimeofday(&wallTime, NULL);
+    getrusage(RUSAGE_SELF, &usage);
+
+    time.wall = wallTime.tv_sec + wallTime.tv_usec / 1e6;
+    time.cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    // ru_maxrss is in kilobytes on Linux.
+    time.peakRss = usage.ru_maxrss;
+    return time;
+}
+
+/* Start timing the provided phase, pausing the phase it is nested in. */
+void startPhase(CompilePhase phase) {
+    if (isTimeReportEnabled()) {
+        chargeCurrentPhase();
+        phaseStack.push_back(phase);
+    }
+}
+
+/* Stop timing the current phase, resuming the phase it is nested in. */
+void endPhase() {
+    if (isTimeReportEnabled() && !phaseStack.empty()) {
+        chargeCurrentPhase();
+        phaseStack.pop_back();
+    }
+}
+
+/* Start timing the lex phase if the next token is one of the sampled tokens,
+   returning true if it is. */
+bool startTokenSample() {
+    if (!isTimeReportEnabled() || tokenCount++ % LEX_SAMPLE_INTERVAL != 0) {
+        return false;
+    }
+
+    startPhase(PHASE_LEX);
+    return true;
+}
+
+/* Stop timing a sampled token. Its time stands for the whole interval, so the
+   rest of the interval is moved to the lex phase from the phase it is nested
+   in, which scanned the tokens that were not timed. */
+void endTokenSample() {
+    if (!isTimeReportEnabled() || phaseStack.empty()) {
+        return;
+    }
+
+    CompileTime sample = phaseTimes[PHASE_LEX];
+    endPhase();
+    if (phaseStack.empty()) {
+        return;
+    }
+
+    CompileTime& outerTime = phaseTimes[phaseStack.back()];
+    double wall = min((phaseTimes[PHASE_LEX].wall - sample.wall) * (LEX_SAMPLE_INTERVAL - 1), outerTime.wall);
+    double cpu = min((phaseTimes[PHASE_LEX].cpu - sample.cpu) * (LEX_SAMPLE_INTERVAL - 1), outerTime.cpu);
+    phaseTimes[PHASE_LEX].wall += wall;
+    phaseTimes[PHASE_LEX].cpu += cpu;
+    outerTime.wall -= wall;
+    outerTime.cpu -= cpu;
+}
+
+void countAstNode() {
+    astNodeCount++;
+}
+
+/* Count the blocks and instructions generated for the function, before it is optimized. */
+void countGeneratedCode(Function* function) {
+    if (isTimeReportEnabled()) {
+        pendingFunction.blocks = function->size();
+        pendingFunction.instructions = countInstructions(function);
+        blockCount += pendingFunction.blocks;
+        instructionCount += pendingFunction.instructions;
+    }
+}
+
+/* Record the time spent on the function since the provided start time,
+   along with the counts from countGeneratedCode. */
+void recordFunction(Function* function, CompileTime startTime) {
+    if (isTimeReportEnabled()) {
+        CompileTime now = getCompileTime();
+        pendingFunction.name = function->getName();
+        pendingFunction.time.wall = now.wall - startTime.wall;
+        pendingFunction.time.cpu = now.cpu - startTime.cpu;
+        functionStats.push_back(pendingFunction);
+    }
+}
+
+/* Print the report as text, followed by the timings of the LLVM passes. */
+static void printTextReport(unsigned finalInstructionCount, long peakRss) {
+    CompileTime total = { 0.0, 0.0, 0 };
+
+    fprintf(stderr, "===--- Decaf compile time report ---===\n");
+    fprintf(stderr, "%-24s %10s %10s %16s\n", "Phase", "Wall (s)", "CPU (s)", "RSS growth (KB)");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        fprintf(stderr, "%-24s %10.4f %10.4f %16ld\n", PHASE_NAMES[i], phaseTimes[i].wall, phaseTimes[i].cpu,
+                phaseTimes[i].peakRss);
+        total.wall += phaseTimes[i].wall;
+        total.cpu += phaseTimes[i].cpu;
+    }
+    fprintf(stderr, "%-24s %10.4f %10.4f\n\n", "total", total.wall, total.cpu);
+
+    fprintf(stderr, "%-24s %10s %10s %8s %12s\n", "Method", "Wall (s)", "CPU (s)", "Blocks", "Instructions");
+    for (size_t i = 0; i < functionStats.size(); i++) {
+        FunctionStats& stats = functionStats[i];
+        fprintf(stderr, "%-24s %10.4f %10.4f %8u %12u\n", stats.name.c_str(), stats.time.wall, stats.time.cpu,
+                stats.blocks, stats.instructions);
+    }
+
+    fprintf(stderr, "\nAST nodes: %u\n", astNodeCount);
+    fprintf(stderr, "Basic blocks generated: %u\n", blockCount);
+    fprintf(stderr, "Instructions before optimization: %u\n", instructionCount);
+    fprintf(stderr, "Instructions after optimization: %u\n", finalInstructionCount);
+    fprintf(stderr, "Peak RSS: %ld KB\n\n", peakRss);
+
+    // Per pass timings collected by LLVM (TimePassesIsEnabled).
+    TimerGroup::printAll(errs());
+}
+
+/* Print the report as a single JSON object. */
+static void printJsonReport(unsigned finalInstructionCount, long peakRss) {
+    fprintf(stderr, "{\"phases\": {");
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        fprintf(stderr, "%s\"%s\": {\"wall\": %.6f, \"cpu\": %.6f, \"rss_growth_kb\": %ld}", (i == 0 ? "" : ", "),
+                PHASE_NAMES[i], phaseTimes[i].wall, phaseTimes[i].cpu, phaseTimes[i].peakRss);
+    }
+
+    fprintf(stderr, "}, \"functions\": [");
+    for (size_t i = 0; i < functionStats.size(); i++) {
+        FunctionStats& stats = functionStats[i];
+        fprintf(stderr, "%s{\"name\": \"%s\", \"wall\": %.6f, \"cpu\": %.6f, \"blocks\": %u, \"instructions\": %u}",
+                (i == 0 ? "" : ", "), stats.name.c_str(), stats.time.wall, stats.time.cpu, stats.blocks, stats.instructions);
+    }
+
+    vector<PassTime> passTimes = collectPassTimes();
+    fprintf(stderr, "], \"passes\": [");
+    for (size_t i = 0; i < passTimes.size(); i++) {
+        fprintf(stderr, "%s{\"name\": \"%s\", \"wall\": %.6f}", (i == 0 ? "" : ", "), passTimes[i].name.c_str(),
+                passTimes[i].wall);
+    }
+
+    fprintf(stderr, "], \"ast_nodes\": %u, \"basic_blocks\": %u, \"instructions_before\": %u, "
+            "\"instructions_after\": %u, \"peak_rss_kb\": %ld}\n",
+            astNodeCount, blockCount, instructionCount, finalInstructionCount, peakRss);
+}
+
+/* Print the phase and method timings and the code statistics to standard
+   error, in the format selected by -time-report. */
+void printTimeReport(Module* module) {
+    if (!isTimeReportEnabled()) {
+        return;
+    }
+
+    unsigned finalInstructionCount = 0;
+    for (Module::iterator it = module->begin(); it != module->end(); it++) {
+        finalInstructionCount += countInstructions(it);
+    }
+
+    long peakRss = getCompileTime().peakRss;
+    if (getTimeReport() == TIME_REPORT_JSON) {
+        printJsonReport(finalInstructionCount, peakRss);
+    } else {
+        printTextReport(finalInstructionCount, peakRss);
+    }
+}
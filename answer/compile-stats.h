@@ -0,0 +1,42 @@
+#ifndef COMPILE_STATS_H
+#define COMPILE_STATS_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+
+// CompilePhase - Part of the pipeline timed by -time-report. Time spent in a
+// nested phase (e.g. lexing during parsing) is only counted for the inner phase.
+// Lexing is estimated from a sample of the tokens.
+enum CompilePhase {
+    PHASE_LEX,
+    PHASE_PARSE,
+    PHASE_DECLARATIONS,  // Externs, fields and method headers.
+    PHASE_BODIES,        // Deferred method bodies.
+    PHASE_FUNCTION_PASSES,
+    PHASE_MODULE_PASSES,
+    PHASE_OUTPUT,
+    PHASE_COUNT
+};
+
+// CompileTime - Wall clock and CPU time in seconds, and the peak resident set
+// size in kilobytes so far.
+struct CompileTime {
+    double wall;
+    double cpu;
+    long peakRss;
+};
+
+bool isTimeReportEnabled();
+CompileTime getCompileTime();
+void startPhase(CompilePhase phase);
+void endPhase();
+bool startTokenSample();
+void endTokenSample();
+void countAstNode();
+void countGeneratedCode(Function* function);
+void recordFunction(Function* function, CompileTime startTime);
+void printTimeReport(Module* module);
+
+#endif
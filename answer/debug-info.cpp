@@ -0,0 +1,114 @@
+#include "llvm/ADT/SmallString.h"
+#include "llvm/DebugInfo.h"
+#include "llvm/DIBuilder.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Dwarf.h"
+#include "llvm/Support/FileSystem.h"
+#include "compile-options.h"
+#include "debug-info.h"
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+/* The debug info is a single compile unit for the source, with a subprogram per
+   method and the location of the statement (or loop condition) being generated
+   on every instruction, which is enough for line tables: perf, gdb and the like
+   map addresses to source lines and attribute inlined code to its callers
+   through the locations the inliner records. Locals are not described. */
+
+const char* DEBUG_PRODUCER = "decaf-codegen";
+const char* DEBUG_UNITS = "llvm.dbg.cu";
+const unsigned DEBUG_RUNTIME_VERSION = 0;
+
+/* Create the compile unit of the source, if debug info was requested (-g). */
+void initializeDebugInfo(CompileContext& context) {
+    if (!isDebugInfoEnabled()) {
+        return;
+    }
+
+    SmallString<128> directory;
+    if (sys::fs::current_path(directory)) {
+        directory = ".";
+    }
+
+    // Decaf has no DWARF language code of its own, its statements read as C.
+    context.debugBuilder = new DIBuilder(*context.module);
+    context.debugBuilder->createCompileUnit(dwarf::DW_LANG_C, getSourceName(), directory, DEBUG_PRODUCER,
+                                           getOptimizationLevel() > 0, "", DEBUG_RUNTIME_VERSION);
+    context.debugFile = context.debugBuilder->createFile(getSourceName(), directory);
+}
+
+/* Return the debug type of the Decaf type, which is void for NULL. */
+static DIType getDebugType(CompileContext& context, Type* type) {
+    DIBuilder* builder = context.debugBuilder;
+    if (type->isIntegerTy(1)) {
+        return builder->createBasicType("boolean", 8, 8, dwarf::DW_ATE_boolean);
+    } else if (type->isIntegerTy()) {
+        return builder->createBasicType("int", 32, 32, dwarf::DW_ATE_signed);
+    } else if (type->isPointerTy()) {
+        DIType charType = builder->createBasicType("char", 8, 8, dwarf::DW_ATE_signed_char);
+        unsigned pointerSize = DataLayout(context.module).getPointerSizeInBits();
+        return builder->createPointerType(charType, pointerSize, pointerSize, "string");
+    }
+
+    return DIType();
+}
+
+/* Describe the method declared at the location, returning its subprogram (the
+   scope of its locations), or NULL without debug info. */
+MDNode* createMethodDebugInfo(CompileContext& context, Function* function, const SourceLocation& location) {
+    if (context.debugBuilder == NULL) {
+        return NULL;
+    }
+
+    // The return type comes first, then those of the parameters.
+    FunctionType* functionType = function->getFunctionType();
+    vector<Value*> types;
+    types.push_back(getDebugType(context, functionType->getReturnType()));
+    for (unsigned i = 0; i < functionType->getNumParams(); i++) {
+        types.push_back(getDebugType(context, functionType->getParamType(i)));
+    }
+
+    DIBuilder* builder = context.debugBuilder;
+    DIFile file(context.debugFile);
+    DIType type = builder->createSubroutineType(file, builder->getOrCreateArray(types));
+    return builder->createFunction(file, function->getName(), function->getName(), file, location.line, type, false,
+                                   true, location.line, DIDescriptor::FlagPrototyped, getOptimizationLevel() > 0,
+                                   function);
+}
+
+/* Enter the scope of the method whose body is generated next, or leave it with
+   NULL, generating instructions without location until one is set. */
+void setDebugScope(CompileContext& context, MDNode* scope) {
+    context.debugScope = scope;
+    context.builder.SetCurrentDebugLocation(DebugLoc());
+}
+
+/* Give the instructions generated from here on the location, in the scope of
+   the method being generated. */
+void setDebugLocation(CompileContext& context, const SourceLocation& location) {
+    if (context.debugScope != NULL) {
+        context.builder.SetCurrentDebugLocation(DebugLoc::get(location.line, location.column, context.debugScope));
+    }
+}
+
+/* Drop the compile unit from the module of a -jobs worker, whose bodies keep
+   their locations, so that linking its shard does not add a second unit. */
+void detachDebugInfo(CompileContext& context) {
+    NamedMDNode* units = context.module->getNamedMetadata(DEBUG_UNITS);
+    if (units != NULL) {
+        context.module->eraseNamedMetadata(units);
+    }
+}
+
+/* Complete the compile unit with the subprograms once all methods are generated. */
+void finishDebugInfo(CompileContext& context) {
+    if (context.debugBuilder != NULL) {
+        context.debugBuilder->finalize();
+    }
+}
@@ -0,0 +1,17 @@
+#ifndef DEBUG_INFO_H
+#define DEBUG_INFO_H
+
+#include "llvm/IR/Function.h"
+#include "compile-context.h"
+#include "expr-asts.h"
+
+using namespace llvm;
+
+void initializeDebugInfo(CompileContext& context);
+MDNode* createMethodDebugInfo(CompileContext& context, Function* function, const SourceLocation& location);
+void setDebugScope(CompileContext& context, MDNode* scope);
+void setDebugLocation(CompileContext& context, const SourceLocation& location);
+void detachDebugInfo(CompileContext& context);
+void finishDebugInfo(CompileContext& context);
+
+#endif
@@ -1,10 +1,20 @@
 %{
 
+#include "compile-context.h"
+#include "compile-options.h"
+#include "ast-arena.h"
+#include "compile-server.h"
+#include "compile-stats.h"
 #include "exprdefs.h"
 #include "expr-asts.h"
+#include "llvm-emit.h"
+#include "llvm-jit.h"
+#include "llvm-pass.h"
 #include "llvm-util.h"
+#include "parallel-codegen.h"
 #include "symbol-table.h"
 #include "value-constants.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <deque>
@@ -16,31 +26,46 @@
 
 using namespace std;
 
-extern char* yytext;
-extern int yyleng;
-extern int yylineno;
+void verifyCode(CompileContext& context);
+void generateExterns(CompileContext& context, ExternList* externList);
+void generateClass(CompileContext& context, ExprList* exprList);
 
-void verifyCode();
-char* copyString(char* str, int length);
-char escapeCharacter(char escapedChar);
-void generateExterns(vector<ExternExprAst*>* externList);
-void generateClass(deque<ExprAst*>* exprList);
+%}
 
-static deque<FunctionExprAst*> functionList;
+%define api.pure
+%locations
+%parse-param { CompileContext* context }
+%parse-param { void* scanner }
+%lex-param { void* scanner }
 
-%}
+%code provides {
+int yylex(YYSTYPE* lval, YYLTYPE* lloc, void* scanner);
+}
+
+%code {
+/* Give the node the location of the first token of the rule that created it. */
+template <typename T>
+static T* locateNode(T* node, const YYLTYPE& location) {
+    SourceLocation sourceLocation = { location.first_line, location.first_column };
+    node->setLocation(sourceLocation);
+    return node;
+}
+}
 
 %union {
-    class vector<ExternExprAst*>* externList;
+    ExternList* externList;
     class ExternExprAst* externExpr;
-    class vector<Type*>* typeList;
-    class deque<ExprAst*>* exprList;
+    TypeList* typeList;
+    ExprList* exprList;
     class Type* type;
-    class vector<pair<Type*,char*>*>* paramList;
-    class pair<Type*,char*>* param;
+    ParamList* paramList;
+    Param* param;
     class ExprAst* expr;
     int num;
     char* str;
+    DecafType decafType;
+    DecafBinaryOp binaryOp;
+    DecafUnaryOp unaryOp;
 }
 
 %token T_AND T_ASSIGN T_BOOLTYPE T_BREAK T_CLASS T_COMMENT T_COMMA T_CONTINUE T_DIV T_DOT T_ELSE T_EQ T_EXTENDS T_EXTERN T_FALSE T_FOR T_GEQ T_GT T_IF T_INTTYPE T_LCB T_LEFTSHIFT T_LEQ T_LPAREN T_LSB T_LT T_MINUS T_MOD T_MULT T_NEQ T_NEW T_NOT T_NULL T_OR T_PLUS T_RCB T_RETURN T_RIGHTSHIFT T_RPAREN T_RSB T_SEMICOLON T_STRINGTYPE T_TRUE T_VOID T_WHILE 
@@ -59,40 +84,43 @@ static deque<FunctionExprAst*> functionList;
 
 %type <expr> field_int field_bool method_declaration variable_int variable_bool statement block assignment method_call statement_while statement_for statement_if statement_return method_argument expression p1_expression p2_expression p3_expression p4_expression p5_expression root_expression expression_variable constant
 
-%type <num> field_quantity number
-%type <str> identifier string extern_type method_type type boolean_constant p1_operator p2_operator p3_operator p4_operator p5_operator unary_operator
+%type <num> field_quantity number boolean_constant
+%type <str> identifier string
+%type <decafType> extern_type method_type type
+%type <binaryOp> p1_operator p2_operator p3_operator p4_operator p5_operator
+%type <unaryOp> unary_operator
 
 %%
 
-program: push_symtbl externs push_symtbl class                                                                                          { generateExterns($2);
-                                                                                                                                          generateClass($4); }
+program: push_symtbl externs push_symtbl class                                                                                          { generateExterns(*context, $2);
+                                                                                                                                          generateClass(*context, $4); }
     ;
 
-externs: externs extern                                                                                                                 { vector<ExternExprAst*>* externList = $1;
+externs: externs extern                                                                                                                 { ExternList* externList = $1;
                                                                                                                                           externList->push_back($2);
                                                                                                                                           $$ = externList; }
-    | extern                                                                                                                            { vector<ExternExprAst*>* externList = new vector<ExternExprAst*>;
+    | extern                                                                                                                            { ExternList* externList = new (context->astArena) ExternList(context->astArena);
                                                                                                                                           externList->push_back($1);
                                                                                                                                           $$ = externList; }
-    | /* No extern declarations */                                                                                                      { $$ = new vector<ExternExprAst*>; } 
+    | /* No extern declarations */                                                                                                      { $$ = new (context->astArena) ExternList(context->astArena); } 
     ;
 
-extern: T_EXTERN method_type identifier T_LPAREN extern_parameters T_RPAREN T_SEMICOLON                                                 { Type* type = getLLVMType($2);
+extern: T_EXTERN method_type identifier T_LPAREN extern_parameters T_RPAREN T_SEMICOLON                                                 { Type* type = getLLVMType(*context, $2);
                                                                                                                                           char* id = $3;
-                                                                                                                                          vector<Type*>* paramTypes = $5;
-                                                                                                                                          $$ = new ExternExprAst(type, id, paramTypes); }
+                                                                                                                                          TypeList* paramTypes = $5;
+                                                                                                                                          $$ = locateNode(new (*context) ExternExprAst(type, id, paramTypes), @$); }
     ;
 
-extern_parameters: extern_parameters T_COMMA extern_parameter                                                                           { vector<Type*>* typeList = $1;
+extern_parameters: extern_parameters T_COMMA extern_parameter                                                                           { TypeList* typeList = $1;
                                                                                                                                           typeList->push_back($3);
                                                                                                                                           $$ = typeList; }
-    | extern_parameter                                                                                                                  { vector<Type*>* typeList = new vector<Type*>;
+    | extern_parameter                                                                                                                  { TypeList* typeList = new (context->astArena) TypeList(context->astArena);
                                                                                                                                           typeList->push_back($1);
                                                                                                                                           $$ = typeList; }
-    | /* No extern parameters */                                                                                                        { $$ = new vector<Type*>; }
+    | /* No extern parameters */                                                                                                        { $$ = new (context->astArena) TypeList(context->astArena); }
     ;
 
-extern_parameter: extern_type                                                                                                           { $$ = getLLVMType($1); }
+extern_parameter: extern_type                                                                                                           { $$ = getLLVMType(*context, $1); }
     ;
 
 class: T_CLASS identifier T_LCB declarations T_RCB                                                                                      { $$ = $4; }
@@ -102,119 +130,119 @@ class: T_CLASS identifier T_LCB declarations T_RCB
 declarations: preceeding_declaration                                                                                                    { $$ = $1; }
     ;
 
-preceeding_declaration: T_INTTYPE field_ints T_SEMICOLON following_declaration                                                          { deque<ExprAst*>* fieldList = $2;
-                                                                                                                                          deque<ExprAst*>* exprList = $4;
+preceeding_declaration: T_INTTYPE field_ints T_SEMICOLON following_declaration                                                          { ExprList* fieldList = $2;
+                                                                                                                                          ExprList* exprList = $4;
                                                                                                                                           exprList->insert(exprList->begin(), fieldList->begin(), fieldList->end());
                                                                                                                                           $$ = exprList; }
-    | T_BOOLTYPE field_bools T_SEMICOLON following_declaration                                                                          { deque<ExprAst*>* fieldList = $2;
-                                                                                                                                          deque<ExprAst*>* exprList = $4;
+    | T_BOOLTYPE field_bools T_SEMICOLON following_declaration                                                                          { ExprList* fieldList = $2;
+                                                                                                                                          ExprList* exprList = $4;
                                                                                                                                           exprList->insert(exprList->begin(), fieldList->begin(), fieldList->end());
                                                                                                                                           $$ = exprList; }
-    | T_INTTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                          { Type* type = getLLVMType(VALUE_INTTYPE);
+    | T_INTTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                          { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $2;
                                                                                                                                           ExprAst* initVal = $4;
-                                                                                                                                          ExprAst* expr = new FieldVarDefExprAst(type, id, initVal);
-                                                                                                                                          deque<ExprAst*>* exprList = $6;
+                                                                                                                                          ExprAst* expr = locateNode(new (*context) FieldVarDefExprAst(type, id, initVal), @$);
+                                                                                                                                          ExprList* exprList = $6;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
-    | T_BOOLTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                         { Type* type = getLLVMType(VALUE_BOOLTYPE);
+    | T_BOOLTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                         { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $2;
                                                                                                                                           ExprAst* initVal = $4;
-                                                                                                                                          ExprAst* expr = new FieldVarDefExprAst(type, id, initVal);
-                                                                                                                                          deque<ExprAst*>* exprList = $6;
+                                                                                                                                          ExprAst* expr = locateNode(new (*context) FieldVarDefExprAst(type, id, initVal), @$);
+                                                                                                                                          ExprList* exprList = $6;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
-    | T_INTTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                         { Type* type = getLLVMType(VALUE_INTTYPE);
+    | T_INTTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                         { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr);
-                                                                                                                                          deque<ExprAst*>* exprList = $7;
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr);
+                                                                                                                                          ExprList* exprList = $7;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
-    | T_BOOLTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                        { Type* type = getLLVMType(VALUE_BOOLTYPE);
+    | T_BOOLTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                        { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr);
-                                                                                                                                          deque<ExprAst*>* exprList = $7;
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr);
+                                                                                                                                          ExprList* exprList = $7;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
     | method_declarations                                                                                                               { $$ = $1; }
     ;
 
-following_declaration: T_INTTYPE field_ints T_SEMICOLON following_declaration                                                           { deque<ExprAst*>* fieldList = $2;
-                                                                                                                                          deque<ExprAst*>* exprList = $4;
+following_declaration: T_INTTYPE field_ints T_SEMICOLON following_declaration                                                           { ExprList* fieldList = $2;
+                                                                                                                                          ExprList* exprList = $4;
                                                                                                                                           exprList->insert(exprList->begin(), fieldList->begin(), fieldList->end());
                                                                                                                                           $$ = exprList; }
-    | T_BOOLTYPE field_bools T_SEMICOLON following_declaration                                                                          { deque<ExprAst*>* fieldList = $2;
-                                                                                                                                          deque<ExprAst*>* exprList = $4;
+    | T_BOOLTYPE field_bools T_SEMICOLON following_declaration                                                                          { ExprList* fieldList = $2;
+                                                                                                                                          ExprList* exprList = $4;
                                                                                                                                           exprList->insert(exprList->begin(), fieldList->begin(), fieldList->end());
                                                                                                                                           $$ = exprList; }
-    | T_INTTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                          { Type* type = getLLVMType(VALUE_INTTYPE);
+    | T_INTTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                          { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $2;
                                                                                                                                           ExprAst* initVal = $4;
-                                                                                                                                          ExprAst* expr = new FieldVarDefExprAst(type, id, initVal);
-                                                                                                                                          deque<ExprAst*>* exprList = $6;
+                                                                                                                                          ExprAst* expr = locateNode(new (*context) FieldVarDefExprAst(type, id, initVal), @$);
+                                                                                                                                          ExprList* exprList = $6;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
-    | T_BOOLTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                         { Type* type = getLLVMType(VALUE_BOOLTYPE);
+    | T_BOOLTYPE identifier T_ASSIGN constant T_SEMICOLON following_declaration                                                         { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $2;
                                                                                                                                           ExprAst* initVal = $4;
-                                                                                                                                          ExprAst* expr = new FieldVarDefExprAst(type, id, initVal);
-                                                                                                                                          deque<ExprAst*>* exprList = $6;
+                                                                                                                                          ExprAst* expr = locateNode(new (*context) FieldVarDefExprAst(type, id, initVal), @$);
+                                                                                                                                          ExprList* exprList = $6;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
-    | T_INTTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                         { Type* type = getLLVMType(VALUE_INTTYPE);
+    | T_INTTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                         { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr); 
-                                                                                                                                          deque<ExprAst*>* exprList = $7;
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr); 
+                                                                                                                                          ExprList* exprList = $7;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; } 
-    | T_BOOLTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                        { Type* type = getLLVMType(VALUE_BOOLTYPE);
+    | T_BOOLTYPE identifier T_LPAREN method_parameters T_RPAREN method_block method_declarations                                        { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr);
-                                                                                                                                          deque<ExprAst*>* exprList = $7;
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr);
+                                                                                                                                          ExprList* exprList = $7;
                                                                                                                                           exprList->push_front(expr);
                                                                                                                                           $$ = exprList; }
     | method_declarations                                                                                                               { $$ = $1; }
     ;
 
 
-field_ints: field_ints T_COMMA field_int                                                                                                { deque<ExprAst*>* fieldList = $1;
+field_ints: field_ints T_COMMA field_int                                                                                                { ExprList* fieldList = $1;
                                                                                                                                           fieldList->push_back($3);
                                                                                                                                           $$ = fieldList; }
-    | field_int                                                                                                                         { deque<ExprAst*>* fieldList = new deque<ExprAst*>;
+    | field_int                                                                                                                         { ExprList* fieldList = new (context->astArena) ExprList(context->astArena);
                                                                                                                                           fieldList->push_back($1); 
                                                                                                                                           $$ = fieldList; }
     ;
 
-field_int: identifier field_quantity                                                                                                    { Type* type = getLLVMType(VALUE_INTTYPE);
+field_int: identifier field_quantity                                                                                                    { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $1;
                                                                                                                                           int quantity = $2; 
-                                                                                                                                          $$ = new FieldVarDeclExprAst(type, id, quantity); }
+                                                                                                                                          $$ = locateNode(new (*context) FieldVarDeclExprAst(type, id, quantity), @$); }
     ;
 
-field_bools: field_bools T_COMMA field_bool                                                                                             { deque<ExprAst*>* fieldList = $1;
+field_bools: field_bools T_COMMA field_bool                                                                                             { ExprList* fieldList = $1;
                                                                                                                                           fieldList->push_back($3);
                                                                                                                                           $$ = fieldList;  }
-    | field_bool                                                                                                                        { deque<ExprAst*>* fieldList = new deque<ExprAst*>;
+    | field_bool                                                                                                                        { ExprList* fieldList = new (context->astArena) ExprList(context->astArena);
                                                                                                                                           fieldList->push_back($1); 
                                                                                                                                           $$ = fieldList; }
     ;
 
-field_bool: identifier field_quantity                                                                                                   { Type* type = getLLVMType(VALUE_BOOLTYPE);
+field_bool: identifier field_quantity                                                                                                   { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $1;
                                                                                                                                           int quantity = $2; 
-                                                                                                                                          $$ = new FieldVarDeclExprAst(type, id, quantity); }
+                                                                                                                                          $$ = locateNode(new (*context) FieldVarDeclExprAst(type, id, quantity), @$); }
     ;
 
 field_quantity: T_LSB number T_RSB                                                                                                      { $$ = $2; }
@@ -223,57 +251,57 @@ field_quantity: T_LSB number T_RSB
 
 
 
-method_declarations: method_declarations method_declaration                                                                             { deque<ExprAst*>* exprList = $1;
+method_declarations: method_declarations method_declaration                                                                             { ExprList* exprList = $1;
                                                                                                                                           exprList->push_back($2);
                                                                                                                                           $$ = exprList; }
-    | method_declaration                                                                                                                { deque<ExprAst*>* exprList = new deque<ExprAst*>;
+    | method_declaration                                                                                                                { ExprList* exprList = new (context->astArena) ExprList(context->astArena);
                                                                                                                                           exprList->push_back($1);
                                                                                                                                           $$ = exprList; }
-    | /* No method declarations */                                                                                                      { $$ = new deque<ExprAst*>; }
+    | /* No method declarations */                                                                                                      { $$ = new (context->astArena) ExprList(context->astArena); }
     ;
 
-method_declaration: T_INTTYPE identifier T_LPAREN method_parameters T_RPAREN method_block                                               { Type* type = getLLVMType(VALUE_INTTYPE);
+method_declaration: T_INTTYPE identifier T_LPAREN method_parameters T_RPAREN method_block                                               { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr);
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr);
                                                                                                                                           $$ = expr; }
-    | T_BOOLTYPE identifier T_LPAREN method_parameters T_RPAREN method_block                                                            { Type* type = getLLVMType(VALUE_BOOLTYPE);
+    | T_BOOLTYPE identifier T_LPAREN method_parameters T_RPAREN method_block                                                            { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr);
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr);
                                                                                                                                           $$ = expr; }
-    | T_VOID identifier T_LPAREN method_parameters T_RPAREN method_block                                                                { Type* type = getLLVMType(VALUE_VOIDTYPE);
+    | T_VOID identifier T_LPAREN method_parameters T_RPAREN method_block                                                                { Type* type = getLLVMType(*context, TYPE_VOID);
                                                                                                                                           char* id = $2;
-                                                                                                                                          vector<pair<Type*,char*>*>* paramList = $4;
-                                                                                                                                          deque<ExprAst*>* stmtList = $6;
-                                                                                                                                          FunctionExprAst* expr = new FunctionExprAst(type, id, paramList, stmtList);
-                                                                                                                                          functionList.push_back(expr);
+                                                                                                                                          ParamList* paramList = $4;
+                                                                                                                                          ExprList* stmtList = $6;
+                                                                                                                                          FunctionExprAst* expr = locateNode(new (*context) FunctionExprAst(type, id, paramList, stmtList), @$);
+                                                                                                                                          context->functionList.push_back(expr);
                                                                                                                                           $$ = expr; }
     ;
 
-method_parameters: method_parameters T_COMMA method_parameter                                                                           { vector<pair<Type*,char*>*>* paramList = $1;
+method_parameters: method_parameters T_COMMA method_parameter                                                                           { ParamList* paramList = $1;
                                                                                                                                           paramList->push_back($3); 
                                                                                                                                           $$ = paramList; }
-    | method_parameter                                                                                                                  { vector<pair<Type*,char*>*>* paramList = new vector<pair<Type*,char*>*>;
+    | method_parameter                                                                                                                  { ParamList* paramList = new (context->astArena) ParamList(context->astArena);
                                                                                                                                           paramList->push_back($1);
                                                                                                                                           $$ = paramList; }
-    | /* No method parameters */                                                                                                        { $$ = new vector<pair<Type*,char*>*>; }
+    | /* No method parameters */                                                                                                        { $$ = new (context->astArena) ParamList(context->astArena); }
     ;
 
-method_parameter: type identifier                                                                                                       { Type* type = getLLVMType($1);
+method_parameter: type identifier                                                                                                       { Type* type = getLLVMType(*context, $1);
                                                                                                                                           char* id = $2; 
-                                                                                                                                          $$ = new pair<Type*,char*>(type, id); }
+                                                                                                                                          $$ = new (context->astArena) Param(type, id); }
     ;
 
-method_block: T_LCB variable_declarations statements T_RCB                                                                              { deque<ExprAst*>* exprList = new deque<ExprAst*>;
-                                                                                                                                          deque<ExprAst*>* varList = $2;
+method_block: T_LCB variable_declarations statements T_RCB                                                                              { ExprList* exprList = new (context->astArena) ExprList(context->astArena);
+                                                                                                                                          ExprList* varList = $2;
                                                                                                                                           exprList->insert(exprList->end(), varList->begin(), varList->end());
                                                                                                                                           // Combine variable declaration list and statement list.
-                                                                                                                                          deque<ExprAst*>* stmtList = $3;
+                                                                                                                                          ExprList* stmtList = $3;
                                                                                                                                           exprList->insert(exprList->end(), stmtList->begin(), stmtList->end());
                                                                                                                                           $$ = exprList; }
     ;
@@ -281,51 +309,51 @@ method_block: T_LCB variable_declarations statements T_RCB
 
 
 
-variable_declarations: variable_declarations variable_declaration                                                                       { deque<ExprAst*>* existingVarList = $1;
-                                                                                                                                          deque<ExprAst*>* newVarList = $2;
+variable_declarations: variable_declarations variable_declaration                                                                       { ExprList* existingVarList = $1;
+                                                                                                                                          ExprList* newVarList = $2;
                                                                                                                                           // Append the variable declarations onto the existing list.
                                                                                                                                           existingVarList->insert(existingVarList->end(), newVarList->begin(), newVarList->end());
                                                                                                                                           $$ = existingVarList;}
     | variable_declaration                                                                                                              { $$ = $1; }
-    | /* No variable declarations */                                                                                                    { $$ = new deque<ExprAst*>; }
+    | /* No variable declarations */                                                                                                    { $$ = new (context->astArena) ExprList(context->astArena); }
     ;
 
 variable_declaration: T_INTTYPE variable_ints T_SEMICOLON                                                                               { $$ = $2; }
     | T_BOOLTYPE variable_bools T_SEMICOLON                                                                                             { $$ = $2; }
     ;
 
-variable_ints: variable_ints T_COMMA variable_int                                                                                       { deque<ExprAst*>* varList = $1;
+variable_ints: variable_ints T_COMMA variable_int                                                                                       { ExprList* varList = $1;
                                                                                                                                           varList->push_back($3);
                                                                                                                                           $$ = varList; }
-    | variable_int                                                                                                                      { deque<ExprAst*>* varList = new deque<ExprAst*>; 
+    | variable_int                                                                                                                      { ExprList* varList = new (context->astArena) ExprList(context->astArena); 
                                                                                                                                           varList->push_back($1);
                                                                                                                                           $$ = varList; }
     ;
              
-variable_int: identifier                                                                                                                { Type* type = getLLVMType(VALUE_INTTYPE);
+variable_int: identifier                                                                                                                { Type* type = getLLVMType(*context, TYPE_INT);
                                                                                                                                           char* id = $1;
-                                                                                                                                          $$ = new VarDeclExprAst(type, id); }
+                                                                                                                                          $$ = locateNode(new (*context) VarDeclExprAst(type, id), @$); }
     ;
 
-variable_bools: variable_bools T_COMMA variable_bool                                                                                    { deque<ExprAst*>* varList = $1;
+variable_bools: variable_bools T_COMMA variable_bool                                                                                    { ExprList* varList = $1;
                                                                                                                                           varList->push_back($3);
                                                                                                                                           $$ = varList; }
-    | variable_bool                                                                                                                     { deque<ExprAst*>* varList = new deque<ExprAst*>; 
+    | variable_bool                                                                                                                     { ExprList* varList = new (context->astArena) ExprList(context->astArena); 
                                                                                                                                           varList->push_back($1);
                                                                                                                                           $$ = varList; }
     ;
               
-variable_bool: identifier                                                                                                               { Type* type = getLLVMType(VALUE_BOOLTYPE);
+variable_bool: identifier                                                                                                               { Type* type = getLLVMType(*context, TYPE_BOOL);
                                                                                                                                           char* id = $1;
-                                                                                                                                          $$ = new VarDeclExprAst(type, id); }
+                                                                                                                                          $$ = locateNode(new (*context) VarDeclExprAst(type, id), @$); }
 
-statements: statements statement                                                                                                        { deque<ExprAst*>* stmtList = $1;
+statements: statements statement                                                                                                        { ExprList* stmtList = $1;
                                                                                                                                           stmtList->push_back($2);
                                                                                                                                           $$ = stmtList; }
-    | statement                                                                                                                         { deque<ExprAst*>* stmtList = new deque<ExprAst*>;
+    | statement                                                                                                                         { ExprList* stmtList = new (context->astArena) ExprList(context->astArena);
                                                                                                                                           stmtList->push_back($1);
                                                                                                                                           $$ = stmtList; }
-    | /* No statements */                                                                                                               { $$ = new deque<ExprAst*>; }
+    | /* No statements */                                                                                                               { $$ = new (context->astArena) ExprList(context->astArena); }
     ;
 
 statement: block                                                                                                                        { $$ = $1; }
@@ -335,75 +363,75 @@ statement: block
     | statement_while                                                                                                                   { $$ = $1; }
     | statement_for                                                                                                                     { $$ = $1; }
     | statement_return T_SEMICOLON                                                                                                      { $$ = $1; }
-    | T_BREAK T_SEMICOLON                                                                                                               { $$ = new BreakExprAst(); }
-    | T_CONTINUE T_SEMICOLON                                                                                                            { $$ = new ContinueExprAst(); }
+    | T_BREAK T_SEMICOLON                                                                                                               { $$ = locateNode(new (*context) BreakExprAst(), @$); }
+    | T_CONTINUE T_SEMICOLON                                                                                                            { $$ = locateNode(new (*context) ContinueExprAst(), @$); }
     ;
 
-block: T_LCB variable_declarations statements T_RCB                                                                                     { deque<ExprAst*>* exprList = new deque<ExprAst*>;
-                                                                                                                                          deque<ExprAst*>* varList = $2;
+block: T_LCB variable_declarations statements T_RCB                                                                                     { ExprList* exprList = new (context->astArena) ExprList(context->astArena);
+                                                                                                                                          ExprList* varList = $2;
                                                                                                                                           exprList->insert(exprList->end(), varList->begin(), varList->end());
                                                                                                                                           // Combine variable declaration list and statement list.
-                                                                                                                                          deque<ExprAst*>* stmtList = $3;
+                                                                                                                                          ExprList* stmtList = $3;
                                                                                                                                           exprList->insert(exprList->end(), stmtList->begin(), stmtList->end());
-                                                                                                                                          $$ = new BlockExprAst(exprList); }
+                                                                                                                                          $$ = locateNode(new (*context) BlockExprAst(exprList), @$); }
      ;
 
 statement_if: T_IF T_LPAREN expression T_RPAREN block                                                                                   { ExprAst* condExpr = $3;
                                                                                                                                           ExprAst* blockExpr = $5;
-                                                                                                                                          $$ = new IfBlockExprAst(condExpr, blockExpr); }
+                                                                                                                                          $$ = locateNode(new (*context) IfBlockExprAst(condExpr, blockExpr), @$); }
     | T_IF T_LPAREN expression T_RPAREN block T_ELSE block                                                                              { ExprAst* condExpr = $3;
                                                                                                                                           ExprAst* trueBlockExpr = $5;
                                                                                                                                           ExprAst* falseBlockExpr = $7;
-                                                                                                                                          $$ = new IfElseBlockExprAst(condExpr, trueBlockExpr, falseBlockExpr); }
+                                                                                                                                          $$ = locateNode(new (*context) IfElseBlockExprAst(condExpr, trueBlockExpr, falseBlockExpr), @$); }
     ;
 
 statement_while: T_WHILE T_LPAREN expression T_RPAREN block                                                                             { ExprAst* condExpr = $3;
                                                                                                                                           ExprAst* blockExpr = $5;
-                                                                                                                                          $$ = new WhileBlockExprAst(condExpr, blockExpr); }
+                                                                                                                                          $$ = locateNode(new (*context) WhileBlockExprAst(condExpr, blockExpr), @$); }
     ;
 
-statement_for: T_FOR T_LPAREN assignments T_SEMICOLON expression T_SEMICOLON assignments T_RPAREN block                                 { deque<ExprAst*>* initList = $3;
+statement_for: T_FOR T_LPAREN assignments T_SEMICOLON expression T_SEMICOLON assignments T_RPAREN block                                 { ExprList* initList = $3;
                                                                                                                                           ExprAst* condExpr = $5; 
-                                                                                                                                          deque<ExprAst*>* updateList = $7;
+                                                                                                                                          ExprList* updateList = $7;
                                                                                                                                           ExprAst* blockExpr = $9;
-                                                                                                                                          $$ = new ForBlockExprAst(initList, condExpr, updateList, blockExpr); }
+                                                                                                                                          $$ = locateNode(new (*context) ForBlockExprAst(initList, condExpr, updateList, blockExpr), @$); }
     ;
 
 statement_return: T_RETURN T_LPAREN expression T_RPAREN                                                                                 { ExprAst* expr = $3;
-                                                                                                                                          $$ = new ReturnExprAst(expr); }
-    | T_RETURN T_LPAREN T_RPAREN                                                                                                        { $$ = new ReturnExprAst(NULL); }
-    | T_RETURN                                                                                                                          { $$ = new ReturnExprAst(NULL); }
+                                                                                                                                          $$ = locateNode(new (*context) ReturnExprAst(expr), @$); }
+    | T_RETURN T_LPAREN T_RPAREN                                                                                                        { $$ = locateNode(new (*context) ReturnExprAst(NULL), @$); }
+    | T_RETURN                                                                                                                          { $$ = locateNode(new (*context) ReturnExprAst(NULL), @$); }
     ;
 
-assignments: assignments T_COMMA assignment                                                                                             { deque<ExprAst*>* exprList = $1; 
+assignments: assignments T_COMMA assignment                                                                                             { ExprList* exprList = $1; 
                                                                                                                                           exprList->push_back($3);
                                                                                                                                           $$ = exprList; }
-    | assignment                                                                                                                        { deque<ExprAst*>* exprList = new deque<ExprAst*>;
+    | assignment                                                                                                                        { ExprList* exprList = new (context->astArena) ExprList(context->astArena);
                                                                                                                                           exprList->push_back($1);
                                                                                                                                           $$ = exprList; } 
-    | /* No assignments */                                                                                                              { $$ = new deque<ExprAst*>; }
+    | /* No assignments */                                                                                                              { $$ = new (context->astArena) ExprList(context->astArena); }
 
 assignment: identifier T_ASSIGN expression                                                                                              { char* id = $1; 
                                                                                                                                           ExprAst* resultExpr = $3;
-                                                                                                                                          $$  = new VarAssignExprAst(id, resultExpr); }
+                                                                                                                                          $$  = locateNode(new (*context) VarAssignExprAst(id, resultExpr), @$); }
     | identifier T_LSB expression T_RSB T_ASSIGN expression                                                                             { char* id = $1;
                                                                                                                                           ExprAst* indexExpr = $3;
                                                                                                                                           ExprAst* resultExpr = $6;
-                                                                                                                                          $$  = new ArrayAssignExprAst(id, indexExpr, resultExpr); }
+                                                                                                                                          $$  = locateNode(new (*context) ArrayAssignExprAst(id, indexExpr, resultExpr), @$); }
     ;
 
 method_call: identifier T_LPAREN method_arguments T_RPAREN                                                                              { char* id = $1;
-                                                                                                                                          deque<ExprAst*>* argList = $3;
-                                                                                                                                          $$ = new FunctionCallExprAst(id, argList); }
+                                                                                                                                          ExprList* argList = $3;
+                                                                                                                                          $$ = locateNode(new (*context) FunctionCallExprAst(id, argList), @$); }
     ;
 
-method_arguments: method_arguments T_COMMA method_argument                                                                              { deque<ExprAst*>* argList = $1;
+method_arguments: method_arguments T_COMMA method_argument                                                                              { ExprList* argList = $1;
                                                                                                                                           argList->push_back($3);
                                                                                                                                           $$ = argList; }
-    | method_argument                                                                                                                   { deque<ExprAst*>* argList = new deque<ExprAst*>;
+    | method_argument                                                                                                                   { ExprList* argList = new (context->astArena) ExprList(context->astArena);
                                                                                                                                           argList->push_back($1);
                                                                                                                                           $$ = argList; }
-    | /* No argument passed */                                                                                                          { $$ = new deque<ExprAst*>; }
+    | /* No argument passed */                                                                                                          { $$ = new (context->astArena) ExprList(context->astArena); }
     ;
 
 method_argument: expression                                                                                                             { $$ = $1; }
@@ -414,143 +442,188 @@ expression: p1_expression
     ;
 
 p1_expression: p2_expression                                                                                                            { $$ = $1; }
-    | p1_expression p1_operator p2_expression                                                                                           { $$ = new SkctBinaryExprAst($2, $1, $3); }
+    | p1_expression p1_operator p2_expression                                                                                           { $$ = locateNode(new (*context) SkctBinaryExprAst($2, $1, $3), @$); }
     ;
 p2_expression: p3_expression                                                                                                            { $$ = $1; }
-    | p2_expression p2_operator p3_expression                                                                                           { $$ = new SkctBinaryExprAst($2, $1, $3); }
+    | p2_expression p2_operator p3_expression                                                                                           { $$ = locateNode(new (*context) SkctBinaryExprAst($2, $1, $3), @$); }
     ;
 
 p3_expression: p4_expression                                                                                                            { $$ = $1; }
-    | p3_expression p3_operator p4_expression                                                                                           { $$ = new BinaryExprAst($2, $1, $3); }
+    | p3_expression p3_operator p4_expression                                                                                           { $$ = locateNode(new (*context) BinaryExprAst($2, $1, $3), @$); }
     ;
 
 p4_expression: p5_expression                                                                                                            { $$ = $1; }
-    | p4_expression p4_operator p5_expression                                                                                           { $$ = new BinaryExprAst($2, $1, $3); }
+    | p4_expression p4_operator p5_expression                                                                                           { $$ = locateNode(new (*context) BinaryExprAst($2, $1, $3), @$); }
     ;
 
 p5_expression: root_expression                                                                                                          { $$ = $1; }
-    | p5_expression p5_operator root_expression                                                                                         { $$ = new BinaryExprAst($2, $1, $3); }
+    | p5_expression p5_operator root_expression                                                                                         { $$ = locateNode(new (*context) BinaryExprAst($2, $1, $3), @$); }
     ;
 
 root_expression: expression_variable                                                                                                    { $$ = $1; }
     | method_call                                                                                                                       { $$ = $1; }
     | constant                                                                                                                          { $$ = $1; }
-    | unary_operator root_expression                                                                                                    { $$ = new UnaryExprAst($1, $2); }
+    | unary_operator root_expression                                                                                                    { $$ = locateNode(new (*context) UnaryExprAst($1, $2), @$); }
     | T_LPAREN expression T_RPAREN                                                                                                      { $$ = $2; }
     ;
 
 expression_variable: identifier                                                                                                         { char* id = $1;
-                                                                                                                                          $$ = new VarExprAst(id); }
+                                                                                                                                          $$ = locateNode(new (*context) VarExprAst(id), @$); }
     | identifier T_LSB expression T_RSB                                                                                                 { char* id = $1; 
                                                                                                                                           ExprAst* indexExpression = $3;
-                                                                                                                                          $$ = new ArrayExprAst(id, indexExpression); }
+                                                                                                                                          $$ = locateNode(new (*context) ArrayExprAst(id, indexExpression), @$); }
     ;
 
-identifier: T_ID                                                                                                                        { $$ = strdup(yytext); }
+identifier: T_ID                                                                                                                        { $$ = $1; }
     ;
 
-extern_type: T_STRINGTYPE                                                                                                               { $$ = (char*) VALUE_STRINGTYPE; }
+extern_type: T_STRINGTYPE                                                                                                               { $$ = TYPE_STRING; }
     | method_type                                                                                                                       { $$ = $1; }
     ;
 
-method_type: T_VOID                                                                                                                     { $$ = (char*) VALUE_VOIDTYPE; }
+method_type: T_VOID                                                                                                                     { $$ = TYPE_VOID; }
     | type                                                                                                                              { $$ = $1; }
     ;
 
-type: T_INTTYPE                                                                                                                         { $$ = (char*) VALUE_INTTYPE; }
-    | T_BOOLTYPE                                                                                                                        { $$ = (char*) VALUE_BOOLTYPE; }
+type: T_INTTYPE                                                                                                                         { $$ = TYPE_INT; }
+    | T_BOOLTYPE                                                                                                                        { $$ = TYPE_BOOL; }
     ;
 
-constant: boolean_constant                                                                                                              { char* boolVal = $1; 
-                                                                                                                                          ExprAst* expr;
-                                                                                                                                          if (strcmp(boolVal, VALUE_TRUE) == 0) { 
-                                                                                                                                              expr = new BoolConstExprAst(true);
-                                                                                                                                          } else { 
-                                                                                                                                              expr = new BoolConstExprAst(false);
-                                                                                                                                          } 
-                                                                                                                                          $$ = expr; }
-    | number                                                                                                                            { $$ = new IntConstExprAst($1); }
-    | string                                                                                                                            { $$ = new StringConstExprAst($1); }
+constant: boolean_constant                                                                                                              { $$ = locateNode(new (*context) BoolConstExprAst($1 != 0), @$); }
+    | number                                                                                                                            { $$ = locateNode(new (*context) IntConstExprAst($1), @$); }
+    | string                                                                                                                            { $$ = locateNode(new (*context) StringConstExprAst($1), @$); }
     ;
 
-boolean_constant: T_TRUE                                                                                                                { $$ = (char*) VALUE_TRUE; }
-    | T_FALSE                                                                                                                           { $$ = (char*) VALUE_FALSE; }
+boolean_constant: T_TRUE                                                                                                                { $$ = 1; }
+    | T_FALSE                                                                                                                           { $$ = 0; }
     ;
 
-string: T_STRINGCONSTANT                                                                                                                { $$ = copyString(yytext, yyleng); }
+string: T_STRINGCONSTANT                                                                                                                { $$ = $1; }
     ;
 
 number: T_INTCONSTANT                                                                                                                   { $$ = $1; }
     | T_CHARCONSTANT                                                                                                                    { $$ = $1;}
     ;
 
-p1_operator: T_OR                                                                                                                       { $$ = (char*) VALUE_OR; }
+p1_operator: T_OR                                                                                                                       { $$ = OP_OR; }
     ;
 
-p2_operator: T_AND                                                                                                                      { $$ = (char*) VALUE_AND; }
+p2_operator: T_AND                                                                                                                      { $$ = OP_AND; }
     ;
 
-p3_operator: T_EQ                                                                                                                       { $$ = (char*) VALUE_EQ; }
-    | T_NEQ                                                                                                                             { $$ = (char*) VALUE_NEQ; }
-    | T_LT                                                                                                                              { $$ = (char*) VALUE_LT; }
-    | T_LEQ                                                                                                                             { $$ = (char*) VALUE_LEQ; }
-    | T_GT                                                                                                                              { $$ = (char*) VALUE_GT; }
-    | T_GEQ                                                                                                                             { $$ = (char*) VALUE_GEQ; }
+p3_operator: T_EQ                                                                                                                       { $$ = OP_EQ; }
+    | T_NEQ                                                                                                                             { $$ = OP_NEQ; }
+    | T_LT                                                                                                                              { $$ = OP_LT; }
+    | T_LEQ                                                                                                                             { $$ = OP_LEQ; }
+    | T_GT                                                                                                                              { $$ = OP_GT; }
+    | T_GEQ                                                                                                                             { $$ = OP_GEQ; }
     ;
 
-p4_operator: T_PLUS                                                                                                                     { $$ = (char*) VALUE_PLUS; }
-    | T_MINUS                                                                                                                           { $$ = (char*) VALUE_MINUS; }
+p4_operator: T_PLUS                                                                                                                     { $$ = OP_PLUS; }
+    | T_MINUS                                                                                                                           { $$ = OP_MINUS; }
 ;
 
-p5_operator: T_MULT                                                                                                                     { $$ = (char*) VALUE_MULT; }
-    | T_DIV                                                                                                                             { $$ = (char*) VALUE_DIV; }
-    | T_MOD                                                                                                                             { $$ = (char*) VALUE_MOD; }
-    | T_RIGHTSHIFT                                                                                                                      { $$ = (char*) VALUE_RIGHTSHIFT; }
-    | T_LEFTSHIFT                                                                                                                       { $$ = (char*) VALUE_LEFTSHIFT; }
+p5_operator: T_MULT                                                                                                                     { $$ = OP_MULT; }
+    | T_DIV                                                                                                                             { $$ = OP_DIV; }
+    | T_MOD                                                                                                                             { $$ = OP_MOD; }
+    | T_RIGHTSHIFT                                                                                                                      { $$ = OP_RIGHTSHIFT; }
+    | T_LEFTSHIFT                                                                                                                       { $$ = OP_LEFTSHIFT; }
     ;
 
-unary_operator: T_NOT                                                                                                                   { $$ = (char*) VALUE_NOT; }
-    | T_MINUS                                                                                                                           { $$ = (char*) VALUE_NEGATE; }
+unary_operator: T_NOT                                                                                                                   { $$ = OP_NOT; }
+    | T_MINUS                                                                                                                           { $$ = OP_NEGATE; }
     ;
 
-push_symtbl: /* Empty */                                                                                                                { pushSymbolTable(); }
+push_symtbl: /* Empty */                                                                                                                { pushSymbolTable(*context); }
     ;
 
 
 %%
 
 // Entry point to program
-int main() {
+int main(int argc, char** argv) {
+    parseCompileOptions(argc, argv);
     initializeLLVM();
 
+    // Keep the process alive and compile each program sent to standard input.
+    if (isServerMode()) {
+        return runCompileServer(stdin, stdout);
+    }
+
+    CompileContext context;
+    startPhase(PHASE_PARSE);
+    int exitVal = parseFile(context, stdin);
+    endPhase();
+    optimizeModule(context);
 
-    int exitVal = yyparse();
+    // The AST is no longer needed once all code has been generated.
+    releaseAstArena(context);
     /* printf("====================================================================================\n"); */
-    getModule()->dump();
-    verifyCode();
-    /* debug(); */
+    if (getOutputMode() == OUTPUT_RUN) {
+        // Run in process instead of handing textual IR to llvm-as/llc/gcc.
+        verifyCode(context);
+        // Report before the program runs, so that its run time is not included.
+        printTimeReport(context.module);
+        return runModule(context.module);
+    }
+
+    startPhase(PHASE_OUTPUT);
+    if (getOutputMode() == OUTPUT_BITCODE) {
+        verifyCode(context);
+        writeBitcode(context.module, getOutputFile());
+    } else if (getOutputMode() == OUTPUT_OBJECT) {
+        verifyCode(context);
+        writeObject(context.module, getOutputFile());
+    } else {
+        context.module->dump();
+        verifyCode(context);
+    }
+    endPhase();
+    printTimeReport(context.module);
+    /* debug(context); */
 
     return (exitVal == EXIT_NO_ERROR ? EXIT_NO_ERROR : EXIT_ERROR);
 }
 
+/* Compile the provided source into the module of the provided (fresh) context,
+   optimizing and verifying it as the driver would. Errors are reported through
+   throwError, so callers must enable recoverable errors to survive them. */
+void compileSource(CompileContext& context, const char* source, int length) {
+    try {
+        if (parseSource(context, source, length) != EXIT_NO_ERROR) {
+            throwError(ERROR_PARSE_FAILED, EXIT_ERROR);
+        }
+        optimizeModule(context);
+        verifyCode(context);
+    } catch (...) {
+        releaseAstArena(context);
+        throw;
+    }
+
+    releaseAstArena(context);
+}
+
 /* Verifies that code satisfies requirements (i.e., has main function, etc). */
-void verifyCode() {
-    Value* main = getValue("main");
+void verifyCode(CompileContext& context) {
+    Value* main = getValue(context, internIdentifier(context, "main"));
     if (main == NULL) {
         throwError(ERROR_NO_MAIN, EXIT_NO_MAIN);
     }
 }
 
 /* Report syntax at with line number and text that caused such to standard error. */
-int yyerror(char const* s) {
-    fprintf(stderr,"%d: %s at %s\n", yylineno, s, yytext);
-    exit(EXIT_ERROR);
+int yyerror(YYLTYPE* location, CompileContext* context, void* scanner, char const* s) {
+    char message[ERROR_MESSAGE_LENGTH];
+    snprintf(message, ERROR_MESSAGE_LENGTH, "%d: %s at %s\n", location->first_line, s, yyget_text(scanner));
+    throwError(message, EXIT_ERROR);
+    return EXIT_ERROR;
 }
 
 /* Copy the provided string, while also converting the escape characters contained within the string to 
-   their normal representation. The allocated string may allocate more space than what is actually needed.*/
-char* copyString(char* str, int length) {
-    char* newStr = (char*) malloc(sizeof(char) * length);
+   their normal representation. The string is allocated in the AST arena of the context, and may allocate more space
+   than what is actually needed.*/
+char* copyString(CompileContext& context, char* str, int length) {
+    char* newStr = (char*) context.astArena.Allocate(sizeof(char) * (length + 1), 1);
     
     char* ptr = newStr;
     while (*str != '\0') {
@@ -609,31 +682,42 @@ char escapeCharacter(char escapedChar) {
             returnChar = '\0';
             break;
         default:
-            fprintf(stderr, "Invalid escaped character.\n");
-            exit(EXIT_FAILURE);
+            throwError(ERROR_INVALID_ESCAPE, EXIT_FAILURE);
+            returnChar = '\0';
      }
     
     return returnChar;
 }
 
 /* Generate code for all externs. */
-void generateExterns(vector<ExternExprAst*>* externList) {
-    for (vector<ExternExprAst*>::iterator it = externList->begin(); it != externList->end(); it++) {
+void generateExterns(CompileContext& context, ExternList* externList) {
+    startPhase(PHASE_DECLARATIONS);
+    for (ExternList::iterator it = externList->begin(); it != externList->end(); it++) {
         ExternExprAst* expr = *it;
-        expr->generateCode();
+        expr->generateCode(context);
     }
+    endPhase();
 }
 
 /* Generate code for the class. */
-void generateClass(deque<ExprAst*>* exprList) {
-    for (deque<ExprAst*>::iterator it = exprList->begin(); it != exprList->end(); it++) {
+void generateClass(CompileContext& context, ExprList* exprList) {
+    startPhase(PHASE_DECLARATIONS);
+    for (ExprList::iterator it = exprList->begin(); it != exprList->end(); it++) {
         ExprAst* expr = *it;
-        expr->generateCode();
+        expr->generateCode(context);
+    }
+    endPhase();
+
+    // Generate deferred (function) code, spread over worker processes if requested.
+    deque<FunctionExprAst*>& functionList = context.functionList;
+    int jobs = min(getJobCount(), (int) functionList.size());
+    if (jobs > 1) {
+        generateDeferedCodeParallel(context, jobs);
+        return;
     }
 
-    // Generate deferred (function) code.
     for (deque<FunctionExprAst*>::iterator it = functionList.begin(); it != functionList.end(); it++) {
         FunctionExprAst* expr = *it;
-        expr->generateDeferedCode();
+        expr->generateDeferedCode(context);
     }
 }
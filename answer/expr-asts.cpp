@@ -1,20 +1,50 @@
+#include "llvm/Support/CFG.h"
+#include "compile-options.h"
+#include "debug-info.h"
 #include "expr-asts.h"
 #include "llvm-pass.h"
 #include "llvm-util.h"
+#include "method-cache.h"
+#include "method-profiler.h"
+#include "profile-guided.h"
+#include "ssa-construction.h"
 #include "symbol-table.h"
 #include <cstdio>
+#include <cstring>
+#include <string>
 #include <vector>
 
-static vector<BasicBlock*>* continueBlockList = new vector<BasicBlock*>;
-static vector<BasicBlock*>* breakBlockList = new vector<BasicBlock*>;
+/* Generate code that branches to the true block if the (bool) expression holds and
+   to the false block otherwise. By default the value is computed and branched on,
+   short circuit expressions branch on their operands instead. */
+void ExprAst::generateCondition(CompileContext& context, BasicBlock* trueBlock, BasicBlock* falseBlock) {
+    Value* conditionValue = generateCode(context);
 
-ExternExprAst::ExternExprAst(Type* returnType, char* identifier, vector<Type*>* parameterTypes) {
+    // Ensure argument is not void (badref).
+    if (conditionValue->getType() == getLLVMType(context, TYPE_VOID)) {
+        throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
+    }
+    validateBoolType(context, conditionValue);
+
+    context.builder.CreateCondBr(conditionValue, trueBlock, falseBlock);
+}
+
+ExternExprAst::ExternExprAst(Type* returnType, char* identifier, TypeList* parameterTypes) {
     type = returnType;
     id = identifier;
     paramTypes = parameterTypes;
 }
-Value* ExternExprAst::generateCode() {
-    return createExternFunction(type, id, paramTypes);
+Value* ExternExprAst::generateCode(CompileContext& context) {
+    return createExternFunction(context, type, id, paramTypes);
+}
+void ExternExprAst::hashNode(AstHash& hash) {
+    hash.addString("extern");
+    hash.addType(type);
+    hash.addString(id);
+    hash.addInt(paramTypes->size());
+    for (TypeList::iterator it = paramTypes->begin(); it != paramTypes->end(); it++) {
+        hash.addType(*it);
+    }
 }
 
 FieldVarDeclExprAst::FieldVarDeclExprAst(Type* dataType, char* identifier, int quantity) {
@@ -22,19 +52,19 @@ FieldVarDeclExprAst::FieldVarDeclExprAst(Type* dataType, char* identifier, int q
     id = identifier;
     size = quantity;
 }
-Value* FieldVarDeclExprAst::generateCode() {
+Value* FieldVarDeclExprAst::generateCode(CompileContext& context) {
     Value* value;
 
     if (size == VALUE_SCALAR) { // For scalar variables
-        if (type == getLLVMType(VALUE_INTTYPE)) { // For integer type
-            Constant* constVal = (Constant*) getIntConstant(0);
-            value = createGlobalScalar(type, id, constVal);
+        if (type == getLLVMType(context, TYPE_INT)) { // For integer type
+            Constant* constVal = (Constant*) getIntConstant(context, 0);
+            value = createGlobalScalar(context, type, id, constVal);
         } else { // For boolean type
-            Constant* constVal = (Constant*) getBoolConstant(false);
-            value = createGlobalScalar(type, id, constVal);
+            Constant* constVal = (Constant*) getBoolConstant(context, false);
+            value = createGlobalScalar(context, type, id, constVal);
         }
     } else if (0 < size)  { // For array variables
-        value = createArray(type, id, size);
+        value = createArray(context, type, id, size);
     } else { // For arrays of size 0;
         throw runtime_error("Invalid error size, must be at least 1.\n");
         throwError(ERROR_INDEX_TOO_LOW, EXIT_ERROR);
@@ -42,56 +72,108 @@ Value* FieldVarDeclExprAst::generateCode() {
 
     return value;
 }
+void FieldVarDeclExprAst::hashNode(AstHash& hash) {
+    hash.addString("field");
+    hash.addType(type);
+    hash.addString(id);
+    hash.addInt(size);
+}
 
 FieldVarDefExprAst::FieldVarDefExprAst(Type* dataType, char* identifier, ExprAst* initialValue) {
     type = dataType;
     id = identifier;
-    value = (Constant*) initialValue->generateCode();
+    valueExpr = initialValue;
 }
-Value* FieldVarDefExprAst::generateCode() {
-   return createGlobalScalar(type, id, value);
+Value* FieldVarDefExprAst::generateCode(CompileContext& context) {
+   Constant* value = (Constant*) valueExpr->generateCode(context);
+   return createGlobalScalar(context, type, id, value);
+}
+void FieldVarDefExprAst::hashNode(AstHash& hash) {
+    hash.addString("fielddef");
+    hash.addType(type);
+    hash.addString(id);
+    valueExpr->hashNode(hash);
 }
 
-FunctionExprAst::FunctionExprAst(Type* returnType, char* identifier, vector<pair<Type*,char*>*>* parameterList, deque<ExprAst*>* statementList) {
+FunctionExprAst::FunctionExprAst(Type* returnType, char* identifier, ParamList* parameterList, ExprList* statementList) {
     type = returnType;
     id = identifier;
     paramList = parameterList;
     stmtList = statementList;
     function = NULL;
     block = NULL;
+    debugScope = NULL;
 }
-Value* FunctionExprAst::generateCode() {
-    function = createFunctionHeader(type, id);
-    block = BasicBlock::Create(getGlobalContext(), BRANCH_ENTRY, function);
-    deque<ExprAst*>* paramExprList = new deque<ExprAst*>;
+Value* FunctionExprAst::generateCode(CompileContext& context) {
+    vector<Type*> paramTypes;
+    for (ParamList::iterator it = paramList->begin(); it != paramList->end(); it++) {
+        paramTypes.push_back((*it)->first);
+    }
 
-    // Add parameters (Arguments) to function header, no code generated yet.
-    for (vector<pair<Type*,char*>*>::iterator it = paramList->begin(); it != paramList->end(); it++) {
-        pair<Type*,char*>* param = *it;
+    function = createFunctionHeader(context, type, id, paramTypes);
+    block = BasicBlock::Create(context.llvmContext, BRANCH_ENTRY, function);
+    debugScope = createMethodDebugInfo(context, function, getLocation());
+    ExprList paramExprList(context.astArena);
+
+    // Name the parameters (Arguments) of the function header, no code generated yet.
+    Function::arg_iterator argIt = function->arg_begin();
+    for (ParamList::iterator it = paramList->begin(); it != paramList->end(); it++, argIt++) {
+        Param* param = *it;
         Type* paramType = param->first;
         char* paramId = param->second;
 
-        Argument* createdParam = new Argument(paramType, paramId, function);
-        FunctionParamExprAst* paramExpr = new FunctionParamExprAst(paramType, paramId, createdParam);
-        paramExprList->push_back(paramExpr);
+        Argument* createdParam = argIt;
+        createdParam->setName(paramId);
+        FunctionParamExprAst* paramExpr = new (context) FunctionParamExprAst(paramType, paramId, createdParam);
+        // The parameters are located at the method, as they are stored on its entry.
+        paramExpr->setLocation(getLocation());
+        paramExprList.push_back(paramExpr);
     }
 
-    stmtList->insert(stmtList->begin(), paramExprList->begin(), paramExprList->end());
+    stmtList->insert(stmtList->begin(), paramExprList.begin(), paramExprList.end());
     
     return function;
 }
-void FunctionExprAst::generateDeferedCode() {
-    getBuilder()->SetInsertPoint(block);
-    pushSymbolTable();
+void FunctionExprAst::hashNode(AstHash& hash) {
+    // The parameters are part of the statement list once the header is generated.
+    hash.addString("method");
+    hash.addType(type);
+    hash.addString(id);
+    hash.addList(stmtList);
+}
+void FunctionExprAst::generateDeferedCode(CompileContext& context) {
+    CompileTime startTime = getCompileTime();
+    startPhase(PHASE_BODIES);
+
+    // Splice in the optimized body of an unchanged method (-cache-dir). Profiled
+    // bodies depend on the counts of a run and debug info on the lines, which the
+    // key does not cover, so they are never cached.
+    string cacheKey;
+    if (getCacheDirectory() != NULL && getProfileMode() == PROFILE_NONE && !isDebugInfoEnabled()) {
+        cacheKey = getMethodCacheKey(context, this);
+        if (loadCachedMethod(context, function, cacheKey)) {
+            // Count the cached body, which is what this compile starts from.
+            countGeneratedCode(function);
+            endPhase();
+            recordFunction(function, startTime);
+            return;
+        }
+    }
+
+    context.builder.SetInsertPoint(block);
+    sealBlock(context, block);
+    setDebugScope(context, debugScope);
+    pushSymbolTable(context);
     bool hasReturn = false;
 
-    for (deque<ExprAst*>::iterator it = stmtList->begin(); it != stmtList->end(); it++) {
+    for (ExprList::iterator it = stmtList->begin(); it != stmtList->end(); it++) {
         ExprAst* expr = *it;
-        expr->generateCode();
+        setDebugLocation(context, expr->getLocation());
+        expr->generateCode(context);
 
         // Check if a terminating (return) statement was generated,
         // and halt code generation if so.
-        if (getBuilder()->GetInsertBlock()->getTerminator() != NULL) {
+        if (context.builder.GetInsertBlock()->getTerminator() != NULL) {
             hasReturn = true;
             break;
         }
@@ -99,10 +181,24 @@ void FunctionExprAst::generateDeferedCode() {
 
     // Add default return if no return statement was present.
     if (!hasReturn) {
-        createDefaultReturn(type);
+        createDefaultReturn(context, type);
+    }
+    popSymbolTable(context);
+    releaseLocalVariables(context);
+    setDebugScope(context, NULL);
+    profileFunction(context, function);
+    optimizeFunction(context, function);
+    if (isMethodInstrumentationEnabled()) {
+        instrumentMethod(context, function);
     }
-    getFunctionPassManager()->run(*function);
-    popSymbolTable();
+    if (!cacheKey.empty()) {
+        storeCachedMethod(context, function, cacheKey);
+    }
+    endPhase();
+    recordFunction(function, startTime);
+}
+Function* FunctionExprAst::getFunction() {
+    return function;
 }
 
 FunctionParamExprAst::FunctionParamExprAst(Type* dataType, char* identifier, Argument* parameter) {
@@ -110,179 +206,190 @@ FunctionParamExprAst::FunctionParamExprAst(Type* dataType, char* identifier, Arg
     id = identifier;
     param = parameter;
 }
-Value* FunctionParamExprAst::generateCode() {
-    storeParameter(type, id, param);
+Value* FunctionParamExprAst::generateCode(CompileContext& context) {
+    storeParameter(context, type, id, param);
+}
+void FunctionParamExprAst::hashNode(AstHash& hash) {
+    hash.addString("param");
+    hash.addType(type);
+    hash.addString(id);
 }
 
-BlockExprAst::BlockExprAst(deque<ExprAst*>* statementList) {
+BlockExprAst::BlockExprAst(ExprList* statementList) {
     stmtList = statementList;
 }
-Value* BlockExprAst::generateCode() {
-    pushSymbolTable();
+Value* BlockExprAst::generateCode(CompileContext& context) {
+    pushSymbolTable(context);
 
-    for (deque<ExprAst*>::iterator it = stmtList->begin(); it != stmtList->end(); it++) {
+    for (ExprList::iterator it = stmtList->begin(); it != stmtList->end(); it++) {
         ExprAst* expr = *it;
-        expr->generateCode();
+        setDebugLocation(context, expr->getLocation());
+        expr->generateCode(context);
         
         // Check if a terminating (return) statement was generated,
         // and halt code generation if so.
-        if (getBuilder()->GetInsertBlock()->getTerminator() != NULL) {
+        if (context.builder.GetInsertBlock()->getTerminator() != NULL) {
             break;
         }
     }
 
-    popSymbolTable();
+    popSymbolTable(context);
+}
+void BlockExprAst::hashNode(AstHash& hash) {
+    hash.addString("block");
+    hash.addList(stmtList);
 }
 
-ForBlockExprAst::ForBlockExprAst(deque<ExprAst*>* initAssignList, ExprAst* conditionExpression, deque<ExprAst*>* updateAssignList, ExprAst* blockExpression) {
+ForBlockExprAst::ForBlockExprAst(ExprList* initAssignList, ExprAst* conditionExpression, ExprList* updateAssignList, ExprAst* blockExpression) {
     initList = initAssignList;
     condExpr = conditionExpression;
     updateList = updateAssignList;
     blockExpr = blockExpression;
 }
-Value* ForBlockExprAst::generateCode() {
+Value* ForBlockExprAst::generateCode(CompileContext& context) {
     if (initList->empty()) {
         throw runtime_error("For loop variable initialization assignments list is empty.\n");
     } else if (updateList->empty()) {
         throw runtime_error("For loop variable update assignments list is empty.\n");
     }
 
-    Function* currentFunction = getBuilder()->GetInsertBlock()->getParent();
-    BasicBlock* loopBlock = BasicBlock::Create(getGlobalContext(), BRANCH_LOOP, currentFunction);
-    BasicBlock* bodyBlock = BasicBlock::Create(getGlobalContext(), BRANCH_BODY, currentFunction);
-    BasicBlock* nextBlock = BasicBlock::Create(getGlobalContext(), BRANCH_NEXT, currentFunction);
-    BasicBlock* endBlock = BasicBlock::Create(getGlobalContext(), BRANCH_END, currentFunction);
+    Function* currentFunction = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* loopBlock = BasicBlock::Create(context.llvmContext, BRANCH_LOOP, currentFunction);
+    BasicBlock* bodyBlock = BasicBlock::Create(context.llvmContext, BRANCH_BODY, currentFunction);
+    BasicBlock* nextBlock = BasicBlock::Create(context.llvmContext, BRANCH_NEXT, currentFunction);
+    BasicBlock* endBlock = BasicBlock::Create(context.llvmContext, BRANCH_END, currentFunction);
 
     // Add entry/exit blocks to list for continue/break statements.
-    continueBlockList->push_back(nextBlock);
-    breakBlockList->push_back(endBlock);
+    context.continueBlocks.push_back(nextBlock);
+    context.breakBlocks.push_back(endBlock);
 
     // Generate variable initialization.
-    for (deque<ExprAst*>::iterator it = initList->begin(); it != initList->end(); it++) {
+    for (ExprList::iterator it = initList->begin(); it != initList->end(); it++) {
         ExprAst* expr = *it;
-        expr->generateCode();
+        setDebugLocation(context, expr->getLocation());
+        expr->generateCode(context);
     }
 
     // Create block and branch to loop.
-    getBuilder()->CreateBr(loopBlock);
-    // Start enty point for loop.
-    getBuilder()->SetInsertPoint(loopBlock);
-    Value* conditionValue = condExpr->generateCode();
-    
-    // Ensure argument is not void (badref).
-    if (conditionValue->getType() == getLLVMType(VALUE_VOIDTYPE)) {
-        throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
-    }
-
-    // Create conditional branch to either body or end.
-    getBuilder()->CreateCondBr(conditionValue, bodyBlock, endBlock);
+    context.builder.CreateBr(loopBlock);
+    // Start enty point for loop, and branch to either body or end.
+    context.builder.SetInsertPoint(loopBlock);
+    setDebugLocation(context, condExpr->getLocation());
+    condExpr->generateCondition(context, bodyBlock, endBlock);
 
     // Create body block and branch to next.
-    getBuilder()->SetInsertPoint(bodyBlock);
-    blockExpr->generateCode();
+    context.builder.SetInsertPoint(bodyBlock);
+    sealBlock(context, bodyBlock);
+    blockExpr->generateCode(context);
     // Only generate branch statement if no other terminating statement found.
-    if (getBuilder()->GetInsertBlock()->getTerminator() == NULL) {
-        getBuilder()->CreateBr(nextBlock);
+    if (context.builder.GetInsertBlock()->getTerminator() == NULL) {
+        context.builder.CreateBr(nextBlock);
     }
 
-    // Create next block and branch back to loop.
-    getBuilder()->SetInsertPoint(nextBlock);
+    // Create next block and branch back to loop, all continue statements are generated.
+    context.builder.SetInsertPoint(nextBlock);
+    sealBlock(context, nextBlock);
     // Generate variable re-assignments.
-    for (deque<ExprAst*>::iterator it = updateList->begin(); it != updateList->end(); it++) {
+    for (ExprList::iterator it = updateList->begin(); it != updateList->end(); it++) {
         ExprAst* expr = *it;
-        expr->generateCode();
+        setDebugLocation(context, expr->getLocation());
+        expr->generateCode(context);
     }
-    getBuilder()->CreateBr(loopBlock);
+    context.builder.CreateBr(loopBlock);
+    sealBlock(context, loopBlock);
 
-    // Create return (end) point.
-    getBuilder()->SetInsertPoint(endBlock); 
+    // Create return (end) point, all break statements are generated.
+    context.builder.SetInsertPoint(endBlock); 
+    sealBlock(context, endBlock);
 
     // Remove entry/exit blocks from list.
-    continueBlockList->pop_back();
-    breakBlockList->pop_back();
+    context.continueBlocks.pop_back();
+    context.breakBlocks.pop_back();
+}
+void ForBlockExprAst::hashNode(AstHash& hash) {
+    hash.addString("for");
+    hash.addList(initList);
+    condExpr->hashNode(hash);
+    hash.addList(updateList);
+    blockExpr->hashNode(hash);
 }
 
 WhileBlockExprAst::WhileBlockExprAst(ExprAst* conditionExpression, ExprAst* blockExpression) {
     condExpr = conditionExpression;
     blockExpr = blockExpression;
 }
-Value* WhileBlockExprAst::generateCode() {
-    Function* currentFunction = getBuilder()->GetInsertBlock()->getParent();
-    BasicBlock* loopBlock = BasicBlock::Create(getGlobalContext(), BRANCH_LOOP, currentFunction);
-    BasicBlock* bodyBlock = BasicBlock::Create(getGlobalContext(), BRANCH_BODY, currentFunction);
-    BasicBlock* endBlock = BasicBlock::Create(getGlobalContext(), BRANCH_END, currentFunction);
+Value* WhileBlockExprAst::generateCode(CompileContext& context) {
+    Function* currentFunction = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* loopBlock = BasicBlock::Create(context.llvmContext, BRANCH_LOOP, currentFunction);
+    BasicBlock* bodyBlock = BasicBlock::Create(context.llvmContext, BRANCH_BODY, currentFunction);
+    BasicBlock* endBlock = BasicBlock::Create(context.llvmContext, BRANCH_END, currentFunction);
     
     // Add entry/exit blocks to list for continue/break statements.
-    continueBlockList->push_back(loopBlock);
-    breakBlockList->push_back(endBlock);
+    context.continueBlocks.push_back(loopBlock);
+    context.breakBlocks.push_back(endBlock);
 
     // Create block and branch to loop.
-    getBuilder()->CreateBr(loopBlock);
-    // Start entry point for loop.
-    getBuilder()->SetInsertPoint(loopBlock);
-    Value* conditionValue = condExpr->generateCode();
-
-    // Ensure argument is not void (badref).
-    if (conditionValue->getType() == getLLVMType(VALUE_VOIDTYPE)) {
-        throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
-    }
-
-    // Create conditional branch to either body or end.
-    getBuilder()->CreateCondBr(conditionValue, bodyBlock, endBlock);
+    context.builder.CreateBr(loopBlock);
+    // Start entry point for loop, and branch to either body or end.
+    context.builder.SetInsertPoint(loopBlock);
+    setDebugLocation(context, condExpr->getLocation());
+    condExpr->generateCondition(context, bodyBlock, endBlock);
 
     // Insert body block code.
-    getBuilder()->SetInsertPoint(bodyBlock);
-    blockExpr->generateCode();
+    context.builder.SetInsertPoint(bodyBlock);
+    sealBlock(context, bodyBlock);
+    blockExpr->generateCode(context);
 
     // Only generate branch statement if no other terminating statement found.
-    if (getBuilder()->GetInsertBlock()->getTerminator() == NULL) {
-        getBuilder()->CreateBr(loopBlock);
+    if (context.builder.GetInsertBlock()->getTerminator() == NULL) {
+        setDebugLocation(context, condExpr->getLocation());
+        context.builder.CreateBr(loopBlock);
     }
+    sealBlock(context, loopBlock);
 
-    // Create return (end) point.
-    getBuilder()->SetInsertPoint(endBlock);
+    // Create return (end) point, all break statements are generated.
+    context.builder.SetInsertPoint(endBlock);
+    sealBlock(context, endBlock);
 
     // Remove entry/exit blocks from list.
-    continueBlockList->pop_back();
-    breakBlockList->pop_back();
+    context.continueBlocks.pop_back();
+    context.breakBlocks.pop_back();
+}
+void WhileBlockExprAst::hashNode(AstHash& hash) {
+    hash.addString("while");
+    condExpr->hashNode(hash);
+    blockExpr->hashNode(hash);
 }
 
 IfBlockExprAst::IfBlockExprAst(ExprAst* conditionExpression, ExprAst* blockExpression) {
     condExpr = conditionExpression;
     blockExpr = blockExpression;
 }
-Value* IfBlockExprAst::generateCode() {
-    Function* currentFunction = getBuilder()->GetInsertBlock()->getParent();
-    BasicBlock* ifstartBlock = BasicBlock::Create(getGlobalContext(), BRANCH_IFSTART, currentFunction);
-    BasicBlock* iftrueBlock = BasicBlock::Create(getGlobalContext(), BRANCH_IFTRUE, currentFunction);
-    BasicBlock* endBlock = BasicBlock::Create(getGlobalContext(), BRANCH_END, currentFunction);
-
-    // Branch to ifstart.
-    getBuilder()->CreateBr(ifstartBlock);
-
-    // Start entry point for ifstart block, and
-    // insert conditional expression code.
-    getBuilder()->SetInsertPoint(ifstartBlock);
-    Value* conditionValue = condExpr->generateCode();
-    
-    // Ensure argument is not void (badref).
-    if (conditionValue->getType() == getLLVMType(VALUE_VOIDTYPE)) {
-        throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
-    }
+Value* IfBlockExprAst::generateCode(CompileContext& context) {
+    Function* currentFunction = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* iftrueBlock = BasicBlock::Create(context.llvmContext, BRANCH_IFTRUE, currentFunction);
+    BasicBlock* endBlock = BasicBlock::Create(context.llvmContext, BRANCH_END, currentFunction);
 
-    // Create conditional branch to either iftrue or end.
-    getBuilder()->CreateCondBr(conditionValue, iftrueBlock, endBlock);
+    // Insert conditional expression code in the current block, branching to either iftrue or end.
+    condExpr->generateCondition(context, iftrueBlock, endBlock);
 
     // Insert iftrue block code.
-    getBuilder()->SetInsertPoint(iftrueBlock);
-    blockExpr->generateCode();
+    context.builder.SetInsertPoint(iftrueBlock);
+    sealBlock(context, iftrueBlock);
+    blockExpr->generateCode(context);
     // Only generate branch statement if no other terminating statement found.
-    if (getBuilder()->GetInsertBlock()->getTerminator() == NULL) {
-        getBuilder()->CreateBr(endBlock);
+    if (context.builder.GetInsertBlock()->getTerminator() == NULL) {
+        context.builder.CreateBr(endBlock);
     }
 
     // Create return (end) point.
-    getBuilder()->SetInsertPoint(endBlock);
+    context.builder.SetInsertPoint(endBlock);
+    sealBlock(context, endBlock);
+}
+void IfBlockExprAst::hashNode(AstHash& hash) {
+    hash.addString("if");
+    condExpr->hashNode(hash);
+    blockExpr->hashNode(hash);
 }
 
 IfElseBlockExprAst::IfElseBlockExprAst(ExprAst* conditionExpression, ExprAst* trueBlockExpression, ExprAst* falseBlockExpression) {
@@ -290,84 +397,99 @@ IfElseBlockExprAst::IfElseBlockExprAst(ExprAst* conditionExpression, ExprAst* tr
     trueBlockExpr = trueBlockExpression;
     falseBlockExpr = falseBlockExpression;
 }
-Value* IfElseBlockExprAst::generateCode() {
-    Function* currentFunction = getBuilder()->GetInsertBlock()->getParent();
-    BasicBlock* ifstartBlock = BasicBlock::Create(getGlobalContext(), BRANCH_IFSTART, currentFunction);
-    BasicBlock* iftrueBlock = BasicBlock::Create(getGlobalContext(), BRANCH_IFTRUE, currentFunction);
-    BasicBlock* iffalseBlock = BasicBlock::Create(getGlobalContext(), BRANCH_IFFALSE, currentFunction);
-    BasicBlock* endBlock = BasicBlock::Create(getGlobalContext(), BRANCH_END, currentFunction);
-
-    // Branch to ifstart.
-    getBuilder()->CreateBr(ifstartBlock);
-    
-    // Start entry point for ifstart block, and
-    // insert conditional expression code.
-    getBuilder()->SetInsertPoint(ifstartBlock);
-    Value* conditionValue = condExpr->generateCode();
+Value* IfElseBlockExprAst::generateCode(CompileContext& context) {
+    Function* currentFunction = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* iftrueBlock = BasicBlock::Create(context.llvmContext, BRANCH_IFTRUE, currentFunction);
+    BasicBlock* iffalseBlock = BasicBlock::Create(context.llvmContext, BRANCH_IFFALSE, currentFunction);
+    BasicBlock* endBlock = BasicBlock::Create(context.llvmContext, BRANCH_END, currentFunction);
 
-    // Ensure argument is not void (badref).
-    if (conditionValue->getType() == getLLVMType(VALUE_VOIDTYPE)) {
-        throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
-    }
+    // Insert conditional expression code in the current block, branching to either iftrue or iffalse.
+    condExpr->generateCondition(context, iftrueBlock, iffalseBlock);
 
-    // Create conditional branch to either iftrue or end.
-    getBuilder()->CreateCondBr(conditionValue, iftrueBlock, iffalseBlock);
-
-    // Insert ifstart block code.
-    getBuilder()->SetInsertPoint(iftrueBlock);
-    trueBlockExpr->generateCode();
+    // Insert iftrue block code.
+    context.builder.SetInsertPoint(iftrueBlock);
+    sealBlock(context, iftrueBlock);
+    trueBlockExpr->generateCode(context);
     // Only generate branch statement if no other terminating statement found.
-    if (getBuilder()->GetInsertBlock()->getTerminator() == NULL) {
-        getBuilder()->CreateBr(endBlock);
+    if (context.builder.GetInsertBlock()->getTerminator() == NULL) {
+        context.builder.CreateBr(endBlock);
     }
 
     // Insert iffalse block code.
-    getBuilder()->SetInsertPoint(iffalseBlock);
-    falseBlockExpr->generateCode();
+    context.builder.SetInsertPoint(iffalseBlock);
+    sealBlock(context, iffalseBlock);
+    falseBlockExpr->generateCode(context);
     // Only generate branch statement if no other terminating statement found.
-    if (getBuilder()->GetInsertBlock()->getTerminator() == NULL) {
-        getBuilder()->CreateBr(endBlock);
+    if (context.builder.GetInsertBlock()->getTerminator() == NULL) {
+        context.builder.CreateBr(endBlock);
     }
 
     // Create return (end) point.
-    getBuilder()->SetInsertPoint(endBlock);
+    context.builder.SetInsertPoint(endBlock);
+    sealBlock(context, endBlock);
+}
+void IfElseBlockExprAst::hashNode(AstHash& hash) {
+    hash.addString("ifelse");
+    condExpr->hashNode(hash);
+    trueBlockExpr->hashNode(hash);
+    falseBlockExpr->hashNode(hash);
 }
 
 ReturnExprAst::ReturnExprAst(ExprAst* expression) {
     expr = expression;
 }
-Value* ReturnExprAst::generateCode() {
+Value* ReturnExprAst::generateCode(CompileContext& context) {
     Value* value;
     if (expr != NULL) {
-        value = expr->generateCode();
+        value = expr->generateCode(context);
         
         // Ensure value is same type as return type.
-        Type* returnType = getBuilder()->GetInsertBlock()->getParent()->getReturnType();
+        Type* returnType = context.builder.GetInsertBlock()->getParent()->getReturnType();
         if (value->getType() != returnType) {
             throwError(ERROR_RETURN_MISMATCH, EXIT_COMPUTE_TYPE_MISMATCH);
         }
 
-        getBuilder()->CreateRet(value);
+        // Mark a directly returned call to the current function as a tail call,
+        // so that tail call elimination can turn the recursion into a loop.
+        CallInst* call = dyn_cast<CallInst>(value);
+        if (call != NULL && call->getCalledFunction() == context.builder.GetInsertBlock()->getParent()) {
+            call->setTailCall();
+        }
+
+        context.builder.CreateRet(value);
     } else {
-        Type* type = getLLVMType(VALUE_VOIDTYPE);
-        value = createDefaultReturn(type);
+        Type* type = getLLVMType(context, TYPE_VOID);
+        value = createDefaultReturn(context, type);
     }
     
     return value;
 }
+void ReturnExprAst::hashNode(AstHash& hash) {
+    hash.addString("return");
+    hash.addInt(expr != NULL);
+    if (expr != NULL) {
+        expr->hashNode(hash);
+    }
+}
 
 BreakExprAst::BreakExprAst() {
 }
-Value* BreakExprAst::generateCode() {
-    BasicBlock* exitBlock = breakBlockList->back();
-    getBuilder()->CreateBr(exitBlock);
+Value* BreakExprAst::generateCode(CompileContext& context) {
+    BasicBlock* exitBlock = context.breakBlocks.back();
+    context.builder.CreateBr(exitBlock);
+}
+void BreakExprAst::hashNode(AstHash& hash) {
+    hash.addString("break");
 }
 
 ContinueExprAst::ContinueExprAst() {
 }
-Value* ContinueExprAst::generateCode() {
-    BasicBlock* nextBlock = continueBlockList->back();
-    getBuilder()->CreateBr(nextBlock);
+Value* ContinueExprAst::generateCode(CompileContext& context) {
+    BasicBlock* nextBlock = context.continueBlocks.back();
+    context.builder.CreateBr(nextBlock);
+}
+void ContinueExprAst::hashNode(AstHash& hash) {
+    hash.addString("continue");
 }
 
 ArrayAssignExprAst::ArrayAssignExprAst(char* identifier, ExprAst* indexExpression,  ExprAst* assignExpression) {
@@ -375,173 +497,229 @@ ArrayAssignExprAst::ArrayAssignExprAst(char* identifier, ExprAst* indexExpressio
     indexExpr = indexExpression;
     assignExpr = assignExpression;
 }
-Value* ArrayAssignExprAst::generateCode() {
-    Value* index = indexExpr->generateCode();
-    Value* value = assignExpr->generateCode();
+Value* ArrayAssignExprAst::generateCode(CompileContext& context) {
+    Value* index = indexExpr->generateCode(context);
+    Value* value = assignExpr->generateCode(context);
 
-    return assignArrayIndex(id, index, value);
+    return assignArrayIndex(context, id, index, value);
+}
+void ArrayAssignExprAst::hashNode(AstHash& hash) {
+    hash.addString("arrayassign");
+    hash.addReference(id);
+    indexExpr->hashNode(hash);
+    assignExpr->hashNode(hash);
 }
 
 VarDeclExprAst::VarDeclExprAst(Type* dataType, char* identifier) {
     type = dataType;
     id = identifier;
 }
-Value* VarDeclExprAst::generateCode() {
-    return declareVariable(type, id);
+Value* VarDeclExprAst::generateCode(CompileContext& context) {
+    return declareVariable(context, type, id);
+}
+void VarDeclExprAst::hashNode(AstHash& hash) {
+    hash.addString("var");
+    hash.addType(type);
+    hash.addString(id);
 }
 
 VarAssignExprAst::VarAssignExprAst(char* identifier, ExprAst* expression) {
     id = identifier;
     expr = expression;
 }
-Value* VarAssignExprAst::generateCode() {
-    Value* value = expr->generateCode();
-    return assignVariable(id, value);
+Value* VarAssignExprAst::generateCode(CompileContext& context) {
+    Value* value = expr->generateCode(context);
+    return assignVariable(context, id, value);
+}
+void VarAssignExprAst::hashNode(AstHash& hash) {
+    hash.addString("assign");
+    hash.addReference(id);
+    expr->hashNode(hash);
 }
 
-SkctBinaryExprAst::SkctBinaryExprAst(char* operation, ExprAst* leftExpression, ExprAst* rightExpression) {
+SkctBinaryExprAst::SkctBinaryExprAst(DecafBinaryOp operation, ExprAst* leftExpression, ExprAst* rightExpression) {
     op = operation;
     lExpr = leftExpression;
     rExpr = rightExpression;
 }
-Value* SkctBinaryExprAst::generateCode() {
-    Value* lValue = lExpr->generateCode();
+Value* SkctBinaryExprAst::generateCode(CompileContext& context) {
+    Function* currentFunction = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* noskctBlock = BasicBlock::Create(context.llvmContext, BRANCH_NOSKCT, currentFunction); 
+    BasicBlock* skctendBlock = BasicBlock::Create(context.llvmContext, BRANCH_SKCTEND, currentFunction);
+
+    // If the left expression decides the result (true for or, false for and), then skip
+    // checking right part of expression by branching to skctend (short circuit), otherwise
+    // branch to noskct (no short circuit).
+    Value* skctValue;
+    if (op == OP_OR) {
+        lExpr->generateCondition(context, skctendBlock, noskctBlock);
+        skctValue = context.builder.getTrue();
+    } else if (op == OP_AND) {
+        lExpr->generateCondition(context, noskctBlock, skctendBlock);
+        skctValue = context.builder.getFalse();
+    } else {
+        throw runtime_error("Invalid binary operation.\n");
+    }
 
-    Value* value;
-    if (strcmp(op, VALUE_OR) == 0) {
-        BasicBlock* currentBlock = getBuilder()->GetInsertBlock();
-        Function* currentFunction = currentBlock->getParent();
-        BasicBlock* noskctBlock = BasicBlock::Create(getGlobalContext(), BRANCH_NOSKCT, currentFunction); 
-        BasicBlock* skctendBlock = BasicBlock::Create(getGlobalContext(), BRANCH_SKCTEND, currentFunction);
-        
-        // If left value evaluates to true, then skip checking right part of expression by
-        // branching to skctend (short circuit), otherwise branch to noskct (no short circuit).
-        getBuilder()->CreateCondBr(lValue, skctendBlock, noskctBlock);
-
-        // Insert code for noskct, evaluate right expression.
-        getBuilder()->SetInsertPoint(noskctBlock);
-        Value* rValue = rExpr->generateCode();
-        Value* result = getBuilder()->CreateOr(lValue, rValue, "ortmp");
-        getBuilder()->CreateBr(skctendBlock);
-        
-        // Insert code for skctend and generate additional code for or expression
-        getBuilder()->SetInsertPoint(skctendBlock);
-        // Create short terminating code.
-        PHINode* node = getBuilder()->CreatePHI(getLLVMType(VALUE_BOOLTYPE), 2, "phival");
-        node->addIncoming(lValue, currentBlock);
-        node->addIncoming(result, noskctBlock);
-
-        value = node;
-        validateBothBoolType(lValue, rValue);
-    } else if (strcmp(op, VALUE_AND) == 0) {
-        BasicBlock* currentBlock = getBuilder()->GetInsertBlock();
-        Function* currentFunction = currentBlock->getParent();
-        BasicBlock* noskctBlock = BasicBlock::Create(getGlobalContext(), BRANCH_NOSKCT, currentFunction); 
-        BasicBlock* skctendBlock = BasicBlock::Create(getGlobalContext(), BRANCH_SKCTEND, currentFunction);
-    
-        // If left value evaluates to false, then skip checking right part of expression by
-        // branching to skctend (short circuit), otherwise branch to noskct (no short circuit).
-        getBuilder()->CreateCondBr(lValue, noskctBlock, skctendBlock);
-
-        // Insert code for noskct, evaluate right expression.
-        getBuilder()->SetInsertPoint(noskctBlock);
-        Value* rValue = rExpr->generateCode();
-        Value* result = getBuilder()->CreateAnd(lValue, rValue, "andtmp");
-        getBuilder()->CreateBr(skctendBlock);
-        
-        // Insert code for skctend and generate additional code for or expression
-        getBuilder()->SetInsertPoint(skctendBlock);
-        // Create short terminating code.
-        PHINode* node = getBuilder()->CreatePHI(getLLVMType(VALUE_BOOLTYPE), 2, "phival");
-        node->addIncoming(lValue, currentBlock);
-        node->addIncoming(result, noskctBlock);
-
-        value = node;
-        validateBothBoolType(lValue, rValue);
+    // Insert code for noskct, the right expression is the result.
+    context.builder.SetInsertPoint(noskctBlock);
+    sealBlock(context, noskctBlock);
+    Value* rValue = rExpr->generateCode(context);
+    validateBoolType(context, rValue);
+    // The right expression may have ended in another block (nested short circuit).
+    BasicBlock* resultBlock = context.builder.GetInsertBlock();
+    context.builder.CreateBr(skctendBlock);
+
+    // Insert code for skctend, merging the short circuit value from every branch of the
+    // left expression with the right value.
+    context.builder.SetInsertPoint(skctendBlock);
+    sealBlock(context, skctendBlock);
+    PHINode* node = context.builder.CreatePHI(getLLVMType(context, TYPE_BOOL), 2, "phival");
+    for (pred_iterator it = pred_begin(skctendBlock); it != pred_end(skctendBlock); it++) {
+        node->addIncoming(*it == resultBlock ? rValue : skctValue, *it);
+    }
+
+    return node;
+}
+/* Branch on the operands, the right operand is only evaluated if the left one does
+   not decide the condition. No value is computed. */
+void SkctBinaryExprAst::generateCondition(CompileContext& context, BasicBlock* trueBlock, BasicBlock* falseBlock) {
+    Function* currentFunction = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* noskctBlock = BasicBlock::Create(context.llvmContext, BRANCH_NOSKCT, currentFunction);
+
+    if (op == OP_OR) {
+        lExpr->generateCondition(context, trueBlock, noskctBlock);
+    } else if (op == OP_AND) {
+        lExpr->generateCondition(context, noskctBlock, falseBlock);
     } else {
         throw runtime_error("Invalid binary operation.\n");
     }
 
-    return value;
+    context.builder.SetInsertPoint(noskctBlock);
+    sealBlock(context, noskctBlock);
+    rExpr->generateCondition(context, trueBlock, falseBlock);
+}
+void SkctBinaryExprAst::hashNode(AstHash& hash) {
+    hash.addString("skct");
+    hash.addInt(op);
+    lExpr->hashNode(hash);
+    rExpr->hashNode(hash);
 }
 
-BinaryExprAst::BinaryExprAst(char* operation, ExprAst* leftExpression, ExprAst* rightExpression) {
+BinaryExprAst::BinaryExprAst(DecafBinaryOp operation, ExprAst* leftExpression, ExprAst* rightExpression) {
     op = operation;
     lExpr = leftExpression;
     rExpr = rightExpression;
 }
-Value* BinaryExprAst::generateCode() {
-    Value* lValue = lExpr->generateCode();
-    Value* rValue = rExpr->generateCode();
+Value* BinaryExprAst::generateCode(CompileContext& context) {
+    Value* lValue = lExpr->generateCode(context);
+    Value* rValue = rExpr->generateCode(context);
 
-    return computeBinaryExpression(op, lValue, rValue);
+    return computeBinaryExpression(context, op, lValue, rValue);
+}
+void BinaryExprAst::hashNode(AstHash& hash) {
+    hash.addString("binary");
+    hash.addInt(op);
+    lExpr->hashNode(hash);
+    rExpr->hashNode(hash);
 }
 
 
 
-UnaryExprAst::UnaryExprAst(char* operation, ExprAst* expression) {
+UnaryExprAst::UnaryExprAst(DecafUnaryOp operation, ExprAst* expression) {
     op = operation;
     expr = expression;
 }
-Value* UnaryExprAst::generateCode() {
-    Value* value = expr->generateCode();
+Value* UnaryExprAst::generateCode(CompileContext& context) {
+    Value* value = expr->generateCode(context);
 
-    return computeUnaryExpression(op, value);
+    return computeUnaryExpression(context, op, value);
+}
+void UnaryExprAst::hashNode(AstHash& hash) {
+    hash.addString("unary");
+    hash.addInt(op);
+    expr->hashNode(hash);
 }
 
-FunctionCallExprAst::FunctionCallExprAst(char* identifier, deque<ExprAst*>* arguments) {
+FunctionCallExprAst::FunctionCallExprAst(char* identifier, ExprList* arguments) {
     id = identifier;
     args = arguments;
 }
-Value* FunctionCallExprAst::generateCode() {
-    vector<Value*>* argValues = new vector<Value*>;
+Value* FunctionCallExprAst::generateCode(CompileContext& context) {
+    vector<Value*> argValues;
 
     // Evaluate argument expressions
-    for (deque<ExprAst*>::iterator it = args->begin(); it != args->end(); it++) {
+    for (ExprList::iterator it = args->begin(); it != args->end(); it++) {
         ExprAst* expr = *it;
-        Value* value = expr->generateCode();
-        argValues->push_back(value);
+        Value* value = expr->generateCode(context);
+        argValues.push_back(value);
     }
 
-    return callFunction(id, argValues);
+    return callFunction(context, id, &argValues);
+}
+void FunctionCallExprAst::hashNode(AstHash& hash) {
+    hash.addString("call");
+    hash.addReference(id);
+    hash.addList(args);
 }
 
 VarExprAst::VarExprAst(char* identifier) {
     id = identifier;
 }
-Value* VarExprAst::generateCode() {
-    return accessVariable(id);
+Value* VarExprAst::generateCode(CompileContext& context) {
+    return accessVariable(context, id);
+}
+void VarExprAst::hashNode(AstHash& hash) {
+    hash.addString("load");
+    hash.addReference(id);
 }
 
 ArrayExprAst::ArrayExprAst(char* identifier, ExprAst* indexExpression) {
     id = identifier;
     indexExpr = indexExpression;
 }
-Value* ArrayExprAst::generateCode() {
-    Value* index = indexExpr->generateCode();
+Value* ArrayExprAst::generateCode(CompileContext& context) {
+    Value* index = indexExpr->generateCode(context);
 
-    return accessArrayIndex(id, index);
+    return accessArrayIndex(context, id, index);
+}
+void ArrayExprAst::hashNode(AstHash& hash) {
+    hash.addString("arrayload");
+    hash.addReference(id);
+    indexExpr->hashNode(hash);
 }
 
 IntConstExprAst::IntConstExprAst(int value) {
     val = value;
 }
-Value* IntConstExprAst::generateCode() {
-    return getIntConstant(val);
+Value* IntConstExprAst::generateCode(CompileContext& context) {
+    return getIntConstant(context, val);
+}
+void IntConstExprAst::hashNode(AstHash& hash) {
+    hash.addString("int");
+    hash.addInt(val);
 }
 
 BoolConstExprAst::BoolConstExprAst(bool value) {
     val = value;
 }
-Value* BoolConstExprAst::generateCode() {
-    return getBoolConstant(val);
+Value* BoolConstExprAst::generateCode(CompileContext& context) {
+    return getBoolConstant(context, val);
+}
+void BoolConstExprAst::hashNode(AstHash& hash) {
+    hash.addString("bool");
+    hash.addInt(val);
 }
 
 StringConstExprAst::StringConstExprAst(char* value) {
-    val = new string(value);
-    val->erase(0, 1);
-    val->erase(val->size() - 1);
+    // Strip the surrounding double quotes of the arena copy made by the scanner.
+    val = value + 1;
+    val[strlen(val) - 1] = '\0';
+}
+Value* StringConstExprAst::generateCode(CompileContext& context) {
+    return createString(context, val);
 }
-Value* StringConstExprAst::generateCode() {
-    return createString(val->c_str());
+void StringConstExprAst::hashNode(AstHash& hash) {
+    hash.addString("string");
+    hash.addString(val);
 }
@@ -2,27 +2,74 @@
 #define EXPR_AST_H
 
 #include "llvm/IR/Value.h"
+#include "ast-arena.h"
+#include "compile-context.h"
+#include "compile-stats.h"
+#include "value-constants.h"
 #include <deque>
+#include <utility>
 #include <vector>
 
 using namespace llvm;
 using namespace std;
 
-// ExprAst - Base class for all expression nodes.
+class AstHash;
+
+// SourceLocation - Line and column (both counted from 1) of the first token of a
+// node, 0 if the node was not created by the parser.
+struct SourceLocation {
+    int line;
+    int column;
+};
+
+// ExprAst - Base class for all expression nodes. Nodes are allocated in the AST
+// arena of their compilation unit, new (context) ..., and are never deleted individually.
+// The parser locates each node it creates (see locateNode in decaf-codegen.y).
 class ExprAst {
+    SourceLocation location;
 public:
+    ExprAst() {
+        location.line = 0;
+        location.column = 0;
+    }
     virtual ~ExprAst() {}
-    virtual Value* generateCode() = 0;
+    virtual Value* generateCode(CompileContext& context) = 0;
+    virtual void generateCondition(CompileContext& context, BasicBlock* trueBlock, BasicBlock* falseBlock);
+    virtual void hashNode(AstHash& hash) = 0;
+
+    const SourceLocation& getLocation() const {
+        return location;
+    }
+    void setLocation(const SourceLocation& sourceLocation) {
+        location = sourceLocation;
+    }
+
+    void* operator new(size_t size, CompileContext& context) {
+        countAstNode();
+        return context.astArena.Allocate(size, AlignOf<ExprAst>::Alignment);
+    }
+    void operator delete(void* ptr, CompileContext& context) {}
+    void operator delete(void* ptr) {}
 };
 
+class ExternExprAst;
+
+// Lists built by the parser, allocated in the AST arena.
+typedef deque<ExprAst*, ArenaAllocator<ExprAst*> > ExprList;
+typedef vector<ExternExprAst*, ArenaAllocator<ExternExprAst*> > ExternList;
+typedef vector<Type*, ArenaAllocator<Type*> > TypeList;
+typedef pair<Type*,char*> Param;
+typedef vector<Param*, ArenaAllocator<Param*> > ParamList;
+
 // ExternExprAst - Expression for an extern (function).
 class ExternExprAst : public ExprAst {
     Type* type;
     char* id;
-    vector<Type*>* paramTypes;
+    TypeList* paramTypes;
 public:
-    ExternExprAst(Type* returnType, char* identifier, vector<Type*>* parameterTypes);
-    virtual Value* generateCode();
+    ExternExprAst(Type* returnType, char* identifier, TypeList* parameterTypes);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // FieldVarDeclExprAst - Expression for a declaring a field variable for both scalars and arrays.
@@ -32,31 +79,36 @@ class FieldVarDeclExprAst : public ExprAst {
     int size;
 public:
     FieldVarDeclExprAst(Type* dataType, char* identifier, int quantity);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // FieldDefExprAst - Expression for a declaring and defining a scalar field variable.
 class FieldVarDefExprAst : public ExprAst {
     Type* type;
     char* id;
-    Constant* value;
+    ExprAst* valueExpr;
 public:
     FieldVarDefExprAst(Type* dataType, char* identifier, ExprAst* initialValue);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // FunctionExprAst - Expresion for a function.
 class FunctionExprAst : public ExprAst {
     Type* type;
     char* id;
-    vector<pair<Type*,char*>*>* paramList;
-    deque<ExprAst*>* stmtList;
+    ParamList* paramList;
+    ExprList* stmtList;
     Function* function;
     BasicBlock* block;
+    MDNode* debugScope;
 public:
-    FunctionExprAst(Type* returnType, char* identifier, vector<pair<Type*,char*>*>* parameterList, deque<ExprAst*>* statementList);
-    virtual Value* generateCode();
-    void generateDeferedCode();
+    FunctionExprAst(Type* returnType, char* identifier, ParamList* parameterList, ExprList* statementList);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
+    void generateDeferedCode(CompileContext& context);
+    Function* getFunction();
 };
 
 // FunctionParamExprAst - Expression for a function parameter.
@@ -66,26 +118,29 @@ class FunctionParamExprAst : public ExprAst {
     Argument* param;
 public:
     FunctionParamExprAst(Type* dataType, char* identifier, Argument* parameter);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // BlockExprAst - Expression for a block of statements.
 class BlockExprAst : public ExprAst {
-    deque<ExprAst*>* stmtList;
+    ExprList* stmtList;
 public:
-    BlockExprAst(deque<ExprAst*>* statementList);
-    virtual Value* generateCode();
+    BlockExprAst(ExprList* statementList);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // ForBlockExprAst - Expression for a for loop.
 class ForBlockExprAst : public ExprAst {
-    deque<ExprAst*>* initList;
+    ExprList* initList;
     ExprAst* condExpr;
-    deque<ExprAst*>* updateList;
+    ExprList* updateList;
     ExprAst* blockExpr;
 public:
-    ForBlockExprAst(deque<ExprAst*>* initAssignList, ExprAst* conditionExpression, deque<ExprAst*>* updateAssignList, ExprAst* blockExpression);
-    virtual Value* generateCode();
+    ForBlockExprAst(ExprList* initAssignList, ExprAst* conditionExpression, ExprList* updateAssignList, ExprAst* blockExpression);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // WhileBlockExprAst - Expression for a while loop.
@@ -94,7 +149,8 @@ class WhileBlockExprAst : public ExprAst {
     ExprAst* blockExpr;
 public:
     WhileBlockExprAst(ExprAst* conditionExpression, ExprAst* blockExpression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // IfBlockExprAst - Expression for an if statement.
@@ -103,7 +159,8 @@ class IfBlockExprAst : public ExprAst {
     ExprAst* blockExpr;
 public:
     IfBlockExprAst(ExprAst* conditionExpression, ExprAst* blockExpression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // IfElseBlockExprAst - Expression for an if/else statement.
@@ -113,7 +170,8 @@ class IfElseBlockExprAst : public ExprAst {
     ExprAst* falseBlockExpr;
 public:
     IfElseBlockExprAst(ExprAst* conditionExpression, ExprAst* trueBlockExpression, ExprAst* falseBlockExpression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // ReturnExprAst - Expression for a return statement. The provided expression
@@ -122,21 +180,24 @@ class ReturnExprAst : public ExprAst {
     ExprAst* expr;
 public:
     ReturnExprAst(ExprAst* expression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // BreakExprAst - Expression for a break statement.
 class BreakExprAst : public ExprAst {
 public:
     BreakExprAst();
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // ContinueExprAst - Expression for a continue statement.
 class ContinueExprAst : public ExprAst {
 public:
     ContinueExprAst();
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // ArrayAssignExprAst - Expression for assigning a value to an index of an array.
@@ -146,7 +207,8 @@ class ArrayAssignExprAst : public ExprAst {
     ExprAst* assignExpr;
 public:
     ArrayAssignExprAst(char* identifier, ExprAst* indexExpression,  ExprAst* assignExpression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // VarDeclExprAst - Expression for variable declarations.
@@ -155,7 +217,8 @@ class VarDeclExprAst : public ExprAst {
     char* id;
 public:
     VarDeclExprAst(Type* dataType, char* identifier);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // VarAssignExprAst - Expression for variable assignments.
@@ -164,45 +227,51 @@ class VarAssignExprAst : public ExprAst {
     ExprAst* expr;
 public:
     VarAssignExprAst(char* identifier, ExprAst* expression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // SkctExprAst - Expression for short-circuited binary expressions.
 class SkctBinaryExprAst : public ExprAst {
-    char* op;
+    DecafBinaryOp op;
     ExprAst* lExpr;
     ExprAst* rExpr;
 public:
-    SkctBinaryExprAst(char* operation, ExprAst* leftExpression, ExprAst* rightExpression);
-    virtual Value* generateCode();
+    SkctBinaryExprAst(DecafBinaryOp operation, ExprAst* leftExpression, ExprAst* rightExpression);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void generateCondition(CompileContext& context, BasicBlock* trueBlock, BasicBlock* falseBlock);
+    virtual void hashNode(AstHash& hash);
 };
 
 // BinaryExprAst - Expression for binary expressions.
 class BinaryExprAst : public ExprAst {
-    char* op;
+    DecafBinaryOp op;
     ExprAst* lExpr;
     ExprAst* rExpr;
 public:
-    BinaryExprAst(char* operation, ExprAst* leftExpression, ExprAst* rightExpression);
-    virtual Value* generateCode();
+    BinaryExprAst(DecafBinaryOp operation, ExprAst* leftExpression, ExprAst* rightExpression);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // UnaryExprAst - Expression for unary expressions.
 class UnaryExprAst : public ExprAst {
-    char* op;
+    DecafUnaryOp op;
     ExprAst* expr;
 public:
-    UnaryExprAst(char* operation, ExprAst* expression);
-    virtual Value* generateCode();
+    UnaryExprAst(DecafUnaryOp operation, ExprAst* expression);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // FunctionCallExprAst - Expression for calling a function.
 class FunctionCallExprAst : public ExprAst {
     char* id;
-    deque<ExprAst*>* args;
+    ExprList* args;
 public:
-    FunctionCallExprAst(char* identifier, deque<ExprAst*>* arguments);
-    virtual Value* generateCode();
+    FunctionCallExprAst(char* identifier, ExprList* arguments);
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // VarExprAst - Expression for accesing variables.
@@ -210,7 +279,8 @@ class VarExprAst : public ExprAst {
     char* id;
 public:
     VarExprAst(char* identifier);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // ArrayExprAst - Expression for accessing an index of an array.
@@ -219,7 +289,8 @@ class ArrayExprAst : public ExprAst {
     ExprAst* indexExpr;
 public:
     ArrayExprAst(char* identifier, ExprAst* indexExpression);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // IntConstExprAst - Expression for integer constants.
@@ -227,7 +298,8 @@ class IntConstExprAst : public ExprAst {
     int val;
 public:
     IntConstExprAst(int value);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // BoolConstExprAst - Expression for boolean constants.
@@ -235,15 +307,17 @@ class BoolConstExprAst : public ExprAst {
     bool val;
 public:
     BoolConstExprAst(bool value);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 // StringConstExprAst - Expression for string constants.
 class StringConstExprAst : public ExprAst {
-    string* val;
+    char* val;
 public:
     StringConstExprAst(char* value);
-    virtual Value* generateCode();
+    virtual Value* generateCode(CompileContext& context);
+    virtual void hashNode(AstHash& hash);
 };
 
 
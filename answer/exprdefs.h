@@ -1,9 +1,10 @@
-
 #ifndef _DECAF_DEFS
 #define _DECAF_DEFS
 
+#include "compile-context.h"
 #include "expr-asts.h"
 #include "llvm/IR/Type.h"
+#include <cstdio>
 #include <deque>
 #include <string>
 #include <vector>
@@ -11,17 +12,17 @@
 using namespace llvm;
 using namespace std;
 
-extern int lineno;
-extern int tokenpos;
-extern char* yytext;
+int parseFile(CompileContext& context, FILE* input);
+int parseSource(CompileContext& context, const char* source, int length);
+void compileSource(CompileContext& context, const char* source, int length);
+char* copyString(CompileContext& context, char* str, int length);
+char escapeCharacter(char escapedChar);
 
-extern "C"
-{
-  int yyerror(const char* s);
-  int yyparse(void);
-  int yylex(void);  
-  int yywrap(void);
-}
+// Pure parser and reentrant scanner, the scanner (yyscan_t) is opaque outside of it.
+struct YYLTYPE;
+int yyerror(struct YYLTYPE* location, CompileContext* context, void* scanner, const char* s);
+int yyparse(CompileContext* context, void* scanner);
+int yyget_lineno(void* scanner);
+char* yyget_text(void* scanner);
 
 #endif
-
@@ -0,0 +1,58 @@
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm-emit.h"
+#include "llvm-target.h"
+#include "value-constants.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace llvm;
+using namespace std;
+
+/* Open the provided file for binary output, halting the program with a
+   failed status if it cannot be opened. */
+static raw_fd_ostream* openOutputFile(const char* fileName) {
+    string errorInfo;
+    raw_fd_ostream* output = new raw_fd_ostream(fileName, errorInfo, raw_fd_ostream::F_Binary);
+    if (!errorInfo.empty()) {
+        fprintf(stderr, "%s: %s\n", fileName, errorInfo.c_str());
+        exit(EXIT_ERROR);
+    }
+
+    return output;
+}
+
+/* Write the module as LLVM bitcode to the provided file. */
+void writeBitcode(Module* module, const char* fileName) {
+    raw_fd_ostream* output = openOutputFile(fileName);
+    WriteBitcodeToFile(module, *output);
+    delete output;
+}
+
+/* Compile the module for the target machine (see llvm-target.cpp) and write
+   the native object to the provided file, taking the place of a separate llc process. */
+void writeObject(Module* module, const char* fileName) {
+    TargetMachine* machine = getTargetMachine();
+    configureModule(module);
+
+    PassManager passManager;
+    addTargetAnalysisPasses(passManager);
+
+    raw_fd_ostream* output = openOutputFile(fileName);
+    {
+        // The formatted stream must be flushed before the file is closed.
+        formatted_raw_ostream formattedOutput(*output);
+        if (machine->addPassesToEmitFile(passManager, formattedOutput, TargetMachine::CGFT_ObjectFile)) {
+            fprintf(stderr, "Target %s cannot emit object files.\n", machine->getTargetTriple().str().c_str());
+            exit(EXIT_ERROR);
+        }
+        passManager.run(*module);
+    }
+
+    delete output;
+}
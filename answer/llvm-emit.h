@@ -0,0 +1,11 @@
+#ifndef LLVM_EMIT_H
+#define LLVM_EMIT_H
+
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+
+void writeBitcode(Module* module, const char* fileName);
+void writeObject(Module* module, const char* fileName);
+
+#endif
@@ -0,0 +1,115 @@
+#include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/JIT.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Module.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
+#include "compile-options.h"
+#include "llvm-jit.h"
+#include "llvm-target.h"
+#include "value-constants.h"
+#include <cstdio>
+#include <cstdlib>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// Decaf standard library, see decaf-stdlib.c.
+extern "C" {
+    struct decaf_profile_entry;
+    struct decaf_method_record;
+
+    void print_int(int x);
+    void print_string(const char* s);
+    void decaf_print_string(const char* s, int length);
+    int read_int();
+    void flush_output();
+    void decaf_profile_start(const decaf_profile_entry* table, int size, const char* path);
+    void decaf_method_enter(decaf_method_record* record);
+    void decaf_method_exit(decaf_method_record* record);
+}
+
+// StdlibSymbol - Name and address of a standard library function.
+struct StdlibSymbol {
+    const char* name;
+    void* address;
+};
+
+static const StdlibSymbol STDLIB_SYMBOLS[] = {
+    { "print_int", (void*) &print_int },
+    { "print_string", (void*) &print_string },
+    { "decaf_print_string", (void*) &decaf_print_string },
+    { "read_int", (void*) &read_int },
+    { "decaf_profile_start", (void*) &decaf_profile_start },
+    { "decaf_method_enter", (void*) &decaf_method_enter },
+    { "decaf_method_exit", (void*) &decaf_method_exit }
+};
+static const int STDLIB_SYMBOL_COUNT = sizeof(STDLIB_SYMBOLS) / sizeof(STDLIB_SYMBOLS[0]);
+
+/* Bind the standard library externs declared by the module directly to the
+   implementations linked into this executable, rather than looking them up. */
+static void mapStandardLibrary(ExecutionEngine* engine, Module* module) {
+    for (int i = 0; i < STDLIB_SYMBOL_COUNT; i++) {
+        Function* function = module->getFunction(STDLIB_SYMBOLS[i].name);
+        if (function != NULL && function->isDeclaration()) {
+            engine->addGlobalMapping(function, STDLIB_SYMBOLS[i].address);
+        }
+    }
+}
+
+/* JIT compile the provided module and call its main function, returning the
+   value returned by main as the exit status (as a native executable would). */
+int runModule(Module* module) {
+    InitializeNativeTarget();
+
+    Function* mainFunction = module->getFunction("main");
+    if (mainFunction == NULL) {
+        throwError(ERROR_NO_MAIN, EXIT_NO_MAIN);
+    }
+
+    // Create the JIT for the processor the module was optimized for. The engine
+    // owns the module until it is removed below, leaving the compile context as
+    // its only owner.
+    TargetMachine* machine = getTargetMachine();
+    vector<string> features = SubtargetFeatures(machine->getTargetFeatureString()).getFeatures();
+    string errorStr;
+    ExecutionEngine* engine = EngineBuilder(module).setEngineKind(EngineKind::JIT).setErrorStr(&errorStr)
+                              .setMCPU(machine->getTargetCPU()).setMAttrs(features).create();
+    if (engine == NULL) {
+        fprintf(stderr, "Could not create ExecutionEngine: %s\n", errorStr.c_str());
+        exit(EXIT_ERROR);
+    }
+    mapStandardLibrary(engine, module);
+
+    void* mainPtr = engine->getPointerToFunction(mainFunction);
+    Type* returnType = mainFunction->getReturnType();
+    int exitVal;
+
+    if (returnType->isVoidTy()) {
+        void (*mainCall)() = (void (*)()) (intptr_t) mainPtr;
+        mainCall();
+        exitVal = EXIT_NO_ERROR;
+    } else if (returnType->isIntegerTy(1)) {
+        bool (*mainCall)() = (bool (*)()) (intptr_t) mainPtr;
+        exitVal = mainCall();
+    } else {
+        int (*mainCall)() = (int (*)()) (intptr_t) mainPtr;
+        exitVal = mainCall();
+    }
+
+    // Output must be visible before the driver exits with main's status.
+    flush_output();
+    fflush(stdout);
+
+    // The profile counters and method records live in the engine's memory and
+    // are written by exit handlers, so an instrumented engine is left to exit.
+    engine->removeModule(module);
+    if (getProfileMode() != PROFILE_GENERATE && !isMethodInstrumentationEnabled()) {
+        delete engine;
+    }
+    return exitVal;
+}
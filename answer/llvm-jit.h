@@ -0,0 +1,10 @@
+#ifndef LLVM_JIT_H
+#define LLVM_JIT_H
+
+#include "llvm/IR/Module.h"
+
+using namespace llvm;
+
+int runModule(Module* module);
+
+#endif
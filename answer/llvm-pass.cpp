@@ -2,26 +2,66 @@
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
 #include "llvm/PassManager.h"
+#include "llvm/Transforms/IPO.h"
+#include "llvm/Transforms/IPO/PassManagerBuilder.h"
 #include "llvm/Transforms/Scalar.h"
+#include "bounds-check.h"
+#include "compile-context.h"
+#include "compile-options.h"
+#include "compile-stats.h"
+#include "debug-info.h"
 #include "llvm-pass.h"
+#include "llvm-target.h"
 #include "llvm-util.h"
+#include "profile-guided.h"
+#include "value-constants.h"
 
 using namespace llvm;
 
-static FunctionPassManager* functionPassManager;
+/* Make every field, array and method except main internal, externs stay
+   declarations (-fwhole-program). Global optimization then turns fields that are
+   never stored into constants and localizes those only used by main, IPSCCP
+   propagates constant arguments, fields and return values across methods, and
+   the arguments, fields and methods left unused are removed. */
+static void addWholeProgramPasses(PassManagerBase& passManager) {
+    const char* exportList[] = { VALUE_MAIN };
+    passManager.add(createInternalizePass(exportList));
+    passManager.add(createGlobalOptimizerPass());
+    // Promote the fields localized into main by global optimization
+    passManager.add(createPromoteMemoryToRegisterPass());
+    passManager.add(createIPSCCPPass());
+    passManager.add(createDeadArgEliminationPass());
+    passManager.add(createGlobalDCEPass());
+}
+
+/* Create the pass managers of the compilation unit for the optimization level. */
+void initializePassManagers(CompileContext& context) {
+    int optLevel = getOptimizationLevel();
+    releasePassManagers(context);
+
+    // No optimization at all for the fastest compile (-O0).
+    if (optLevel == 0) {
+        return;
+    }
+
+    FunctionPassManager* functionPassManager = new FunctionPassManager(context.module);
+    context.functionPassManager = functionPassManager;
+    addTargetAnalysisPasses(*functionPassManager);
 
-void initializePassManagers(Module* module) {
-    char id = 0;
-    functionPassManager = new FunctionPassManager(module);
-    
     // Adds GVN support
     functionPassManager->add(createBasicAliasAnalysisPass());
 
-    // Convert stack allocation usage (alloca) into register usage (mem2reg)
-    functionPassManager->add(createPromoteMemoryToRegisterPass());
+    // Convert stack allocation usage (alloca) into register usage (mem2reg),
+    // unless the locals were already generated in SSA form
+    if (!isDirectSsaEnabled()) {
+        functionPassManager->add(createPromoteMemoryToRegisterPass());
+    }
     
     // Simple "peephole" optimization (instruction combining pass)
     functionPassManager->add(createInstructionCombiningPass());
+
+    // Turn self recursive tail calls (and accumulator recursion) into loops
+    functionPassManager->add(createTailCallEliminationPass());
     
     // Re-associate expression
     functionPassManager->add(createReassociatePass());
@@ -29,10 +69,76 @@ void initializePassManagers(Module* module) {
     // Eliminate common sub-expressions (GVN)
     functionPassManager->add(createGVNPass());
     
+    // Check array bounds once per loop instead of once per access, then
+    // version the loops on the hoisted check (-fbounds-check). LoopSimplify is a
+    // loop pass, which a function pass cannot require, so it is scheduled here to
+    // give the loops preheaders.
+    if (isBoundsCheckEnabled()) {
+        functionPassManager->add(createLoopSimplifyPass());
+        functionPassManager->add(createBoundsCheckHoistingPass());
+        functionPassManager->add(createLoopUnswitchPass());
+        functionPassManager->add(createInstructionCombiningPass());
+    }
+
     // Simplify the control flow graph (CFG simplification)
     functionPassManager->add(createCFGSimplificationPass());
+
+    // Module passes run once all functions are generated, so that every call
+    // site is visible to the inliner.
+    PassManager* modulePassManager = new PassManager();
+    context.modulePassManager = modulePassManager;
+    addTargetAnalysisPasses(*modulePassManager);
+    if (isWholeProgramEnabled()) {
+        addWholeProgramPasses(*modulePassManager);
+    }
+    if (optLevel >= 2) {
+        // Full pipeline: inlining, global optimization, IPSCCP, LICM, loop
+        // rotation, induction variable simplification, loop unrolling, SCCP,
+        // DSE, etc. The loop vectorizer runs on the rotated loops (requiring
+        // loop-simplify and LCSSA form) and the SLP vectorizer packs the
+        // remaining straight-line code, both sized by the target's cost model.
+        PassManagerBuilder builder;
+        builder.OptLevel = optLevel;
+        builder.Inliner = createFunctionInliningPass(getInlineThreshold());
+        builder.LoopVectorize = isVectorizeEnabled();
+        builder.SLPVectorize = isVectorizeEnabled();
+        builder.populateModulePassManager(*modulePassManager);
+    } else {
+        // Inline small methods, clean up the inlined code and remove the
+        // (internal) methods that are no longer called.
+        modulePassManager->add(createFunctionInliningPass(getInlineThreshold()));
+        modulePassManager->add(createInstructionCombiningPass());
+        modulePassManager->add(createCFGSimplificationPass());
+        modulePassManager->add(createGlobalDCEPass());
+    }
+}
+
+/* Delete the pass managers, which must happen before their module is deleted. */
+void releasePassManagers(CompileContext& context) {
+    delete context.functionPassManager;
+    delete context.modulePassManager;
+    context.functionPassManager = NULL;
+    context.modulePassManager = NULL;
+}
+
+/* Run the function passes on the provided function, if any are enabled. */
+void optimizeFunction(CompileContext& context, Function* function) {
+    countGeneratedCode(function);
+    startPhase(PHASE_FUNCTION_PASSES);
+    if (context.functionPassManager != NULL) {
+        context.functionPassManager->run(*function);
+    }
+    endPhase();
 }
 
-FunctionPassManager* getFunctionPassManager() {
-    return functionPassManager;
+/* Run the module passes on the module of the unit, if any are enabled. Must be
+   called after all deferred function code has been generated. */
+void optimizeModule(CompileContext& context) {
+    startPhase(PHASE_MODULE_PASSES);
+    finishProfile(context);
+    finishDebugInfo(context);
+    if (context.modulePassManager != NULL) {
+        context.modulePassManager->run(*context.module);
+    }
+    endPhase();
 }
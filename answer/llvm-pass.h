@@ -6,7 +6,11 @@
 
 using namespace llvm;
 
-void initializePassManagers(Module* module);
-FunctionPassManager* getFunctionPassManager();
+struct CompileContext;
+
+void initializePassManagers(CompileContext& context);
+void releasePassManagers(CompileContext& context);
+void optimizeFunction(CompileContext& context, Function* function);
+void optimizeModule(CompileContext& context);
 
 #endif
@@ -0,0 +1,78 @@
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Module.h"
+#include "llvm/MC/SubtargetFeature.h"
+#include "llvm/PassManager.h"
+#include "llvm/Support/Host.h"
+#include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/Target/TargetMachine.h"
+#include "llvm/Target/TargetOptions.h"
+#include "compile-options.h"
+#include "llvm-target.h"
+#include "value-constants.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace llvm;
+using namespace std;
+
+// Shared by all compile contexts, it is only read once created.
+static TargetMachine* targetMachine = NULL;
+
+/* Create the machine that every module is optimized and compiled for: the host
+   triple with the -mcpu processor, or by default the host processor with all of
+   its detected features. Halts the program if the host target is not available. */
+void initializeTarget() {
+    if (targetMachine != NULL) {
+        return;
+    }
+
+    InitializeNativeTarget();
+    InitializeNativeTargetAsmPrinter();
+
+    string triple = sys::getDefaultTargetTriple();
+    string errorStr;
+    const Target* target = TargetRegistry::lookupTarget(triple, errorStr);
+    if (target == NULL) {
+        fprintf(stderr, "Could not find target %s: %s\n", triple.c_str(), errorStr.c_str());
+        exit(EXIT_ERROR);
+    }
+
+    string cpu = (getTargetCPU() != NULL ? getTargetCPU() : sys::getHostCPUName());
+    SubtargetFeatures features;
+    StringMap<bool> hostFeatures;
+    if (getTargetCPU() == NULL && sys::getHostCPUFeatures(hostFeatures)) {
+        for (StringMap<bool>::iterator it = hostFeatures.begin(); it != hostFeatures.end(); it++) {
+            features.AddFeature(it->getKey(), it->getValue());
+        }
+    }
+
+    targetMachine = target->createTargetMachine(triple, cpu, features.getString(), TargetOptions());
+}
+
+/* Return the machine created by initializeTarget. */
+TargetMachine* getTargetMachine() {
+    if (targetMachine == NULL) {
+        initializeTarget();
+    }
+
+    return targetMachine;
+}
+
+/* Set the triple and data layout of the target machine on the module, so that
+   the optimizers know the size and alignment of every type. */
+void configureModule(Module* module) {
+    TargetMachine* machine = getTargetMachine();
+    module->setTargetTriple(machine->getTargetTriple());
+    module->setDataLayout(machine->getDataLayout()->getStringRepresentation());
+}
+
+/* Add the data layout and the target's cost model (TargetTransformInfo), which
+   the vectorizers and loop passes query for legal vector widths and costs. */
+void addTargetAnalysisPasses(PassManagerBase& passManager) {
+    TargetMachine* machine = getTargetMachine();
+    passManager.add(new DataLayout(*machine->getDataLayout()));
+    machine->addAnalysisPasses(passManager);
+}
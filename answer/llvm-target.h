@@ -0,0 +1,15 @@
+#ifndef LLVM_TARGET_H
+#define LLVM_TARGET_H
+
+#include "llvm/IR/Module.h"
+#include "llvm/PassManager.h"
+#include "llvm/Target/TargetMachine.h"
+
+using namespace llvm;
+
+void initializeTarget();
+TargetMachine* getTargetMachine();
+void configureModule(Module* module);
+void addTargetAnalysisPasses(PassManagerBase& passManager);
+
+#endif
@@ -1,8 +1,20 @@
+#include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/Threading.h"
+#include "bounds-check.h"
+#include "compile-context.h"
+#include "compile-options.h"
+#include "compile-stats.h"
 #include "llvm-pass.h"
+#include "llvm-target.h"
 #include "llvm-util.h"
+#include "profile-guided.h"
+#include "ssa-construction.h"
 #include "symbol-table.h"
 #include "value-constants.h"
 #include <stdexcept>
@@ -20,61 +32,43 @@ const char* BRANCH_BODY = "body";
 const char* BRANCH_NEXT = "next";
 const char* BRANCH_SKCTEND = "skctend";
 const char* BRANCH_NOSKCT = "noskct";
-const char* BRANCH_IFSTART = "ifstart";
 const char* BRANCH_IFTRUE = "iftrue";
 const char* BRANCH_IFFALSE = "iffalse";
-
-static Module* codeModule;
-static IRBuilder<>* irBuilder;
-static FunctionPassManager* passManager;
-
-/* Initialize LLVM components. */
+const char* BRANCH_INBOUNDS = "inbounds";
+const char* BRANCH_TRAP = "trap";
+const char* PRINT_STRING_FUNCTION = "print_string";
+const char* PRINT_STRING_LENGTH_FUNCTION = "decaf_print_string";
+
+/* Create the process wide target machine and profile counts, must be called
+   once the compile options are parsed. Everything else is created per
+   compilation unit by CompileContext. */
 void initializeLLVM() {
-    codeModule = new Module(MODULE_NAME, getGlobalContext());
-    irBuilder = new IRBuilder<>(getGlobalContext());
-    
-    // For code optimization
-    initializePassManagers(codeModule);
-}
-
-/* Return the created module, used to reference current code context. */
-Module* getModule() {
-    return codeModule;
-}
+    llvm_start_multithreaded();
+    initializeTarget();
+    initializeProfile();
 
-/* Return the builder, used to build code generation. */
-IRBuilder<>* getBuilder() {
-    return irBuilder;
+    // Let LLVM time every pass for -time-report.
+    TimePassesIsEnabled = isTimeReportEnabled();
 }
 
-/* Return the the type corresponding to the provided string. */
-Type* getLLVMType(const char* typeStr) {
-    Type* type = NULL;
-
-    if (strcmp(typeStr, VALUE_VOIDTYPE) == 0) {
-        type = irBuilder->getVoidTy();
-    } else if (strcmp(typeStr, VALUE_INTTYPE) == 0) {
-        type = irBuilder->getInt32Ty();
-    } else if (strcmp(typeStr, VALUE_BOOLTYPE) == 0) {
-        type = irBuilder->getInt1Ty();
-    } else if (strcmp(typeStr, VALUE_STRINGTYPE) == 0) {
-        type = irBuilder->getInt8PtrTy();
-    } else {
+/* Return the LLVM type corresponding to the provided Decaf type. */
+Type* getLLVMType(CompileContext& context, DecafType decafType) {
+    if (decafType < 0 || decafType >= TYPE_COUNT) {
         throw runtime_error("Unknown data type.\n");
     }
 
-    return type;
+    return context.typeTable[decafType];
 }
 
 /* Create the default return statement for the provided Type. */
-Value* createDefaultReturn(Type* type) {
+Value* createDefaultReturn(CompileContext& context, Type* type) {
     Value* returnVal;
-    if (type == getLLVMType(VALUE_INTTYPE)) {
-        returnVal = getBuilder()->CreateRet(getIntConstant(EXIT_SUCCESS));
-    } else if (type == getLLVMType(VALUE_BOOLTYPE)) {
-        returnVal = getBuilder()->CreateRet(getBoolConstant(EXIT_SUCCESS));
-    } else if (type == getLLVMType(VALUE_VOIDTYPE)) {
-        returnVal = getBuilder()->CreateRetVoid();
+    if (type == getLLVMType(context, TYPE_INT)) {
+        returnVal = context.builder.CreateRet(getIntConstant(context, EXIT_SUCCESS));
+    } else if (type == getLLVMType(context, TYPE_BOOL)) {
+        returnVal = context.builder.CreateRet(getBoolConstant(context, EXIT_SUCCESS));
+    } else if (type == getLLVMType(context, TYPE_VOID)) {
+        returnVal = context.builder.CreateRetVoid();
     } else {
         throw runtime_error("Invalid return type.\n");
     }
@@ -84,111 +78,160 @@ Value* createDefaultReturn(Type* type) {
 
 
 /* Return the LLVM value representation of the provided integer. */
-Value* getIntConstant(int value) {
-    return irBuilder->getInt32(value);
+Value* getIntConstant(CompileContext& context, int value) {
+    return context.builder.getInt32(value);
 }
 
 /* Return the LLVm value representation of the provided boolean. */
-Value* getBoolConstant(bool value) {
-    return irBuilder->getInt1(value);
+Value* getBoolConstant(CompileContext& context, bool value) {
+    return context.builder.getInt1(value);
 }
 
 /* Convert the provided value, which should be of boolean type, to an integer. 
    This works for both constants and variables. */
-Value* convertBoolToInt(Value* value) {
-    return irBuilder->CreateZExt(value, getLLVMType(VALUE_INTTYPE), "zexttmp");
+Value* convertBoolToInt(CompileContext& context, Value* value) {
+    return context.builder.CreateZExt(value, getLLVMType(context, TYPE_INT), "zexttmp");
 }
 
 
 /* Create an extern function with the provided return type, name and parameter types. */
-Function* createExternFunction(Type* returnType, char* id, vector<Type*>* parameterTypes) {
-    FunctionType* type = FunctionType::get(returnType, *parameterTypes, false);
-    Function* function = Function::Create(type, Function::ExternalLinkage, id, codeModule);
+Function* createExternFunction(CompileContext& context, Type* returnType, char* id, TypeList* parameterTypes) {
+    vector<Type*> types(parameterTypes->begin(), parameterTypes->end());
+    FunctionType* type = FunctionType::get(returnType, types, false);
+    Function* function = Function::Create(type, Function::ExternalLinkage, id, context.module);
     
-    insertExternSymbol(id, function);
+    insertExternSymbol(context, id, function);
     return function;
 }
 
-/* Declare a function with the following return type and id. */
-Function* createFunctionHeader(Type* returnType, char* id) {
-    FunctionType* type = FunctionType::get(returnType, false);
-    Function* function = Function::Create(type, Function::ExternalLinkage, id, codeModule);
+/* Declare a function with the following return type, id and parameter types. Only main
+   is visible outside of the module, so that other methods may be inlined and removed. */
+Function* createFunctionHeader(CompileContext& context, Type* returnType, char* id, vector<Type*>& paramTypes) {
+    FunctionType* type = FunctionType::get(returnType, paramTypes, false);
+    GlobalValue::LinkageTypes linkage = (strcmp(id, VALUE_MAIN) == 0 ? Function::ExternalLinkage : Function::InternalLinkage);
+    Function* function = Function::Create(type, linkage, id, context.module);
 
-    insertFunctionSymbol(id, function);
+    insertFunctionSymbol(context, id, function);
     return function;
 }
 
 /* Create a global string definition for the provided string and return the created value. */
-Value* createString(const char* str) {
-    Value* value = irBuilder->CreateGlobalString(str, "globalstring");
-    return irBuilder->CreateConstGEP2_32(value, 0, 0, "cast");
+Value* createString(CompileContext& context, const char* str) {
+    Value* value = context.builder.CreateGlobalString(str, "globalstring");
+    return context.builder.CreateConstGEP2_32(value, 0, 0, "cast");
 }
 
 /* Create an array of the provided type with the provided id and size. */
-Value* createArray(Type* type, char* id, int size) {
+Value* createArray(CompileContext& context, Type* type, char* id, int size) {
     ArrayType* arrayType = ArrayType::get(type, size);
     
     // Initialize all values to zeroes.
     Constant* zeroInitializer = Constant::getNullValue(arrayType);
     
     //Create global variable to array.
-    GlobalVariable* variable = new GlobalVariable(*codeModule, arrayType, false, GlobalValue::ExternalLinkage, zeroInitializer, id);
-    insertSymbol(id, variable);
+    GlobalVariable* variable = new GlobalVariable(*context.module, arrayType, false, GlobalValue::ExternalLinkage, zeroInitializer, id);
+    insertSymbol(context, id, variable);
 
     return variable;
 }
 
 /* Create a global scalar variable with the provided type and id, and initialize it with the provided value. */
-Value* createGlobalScalar(Type* type, char* id, Constant* value) {
-    GlobalVariable* variable = new GlobalVariable(*codeModule, type, false, GlobalValue::ExternalLinkage, value, id);
-    insertSymbol(id, variable); 
+Value* createGlobalScalar(CompileContext& context, Type* type, char* id, Constant* value) {
+    GlobalVariable* variable = new GlobalVariable(*context.module, type, false, GlobalValue::ExternalLinkage, value, id);
+    insertSymbol(context, id, variable); 
 
     return variable;
 }
 
+/* Return the block that traps on an out of bounds array index in the current
+   function, creating it if needed. All checks of a function share it. */
+static BasicBlock* getTrapBlock(CompileContext& context) {
+    Function* function = context.builder.GetInsertBlock()->getParent();
+    if (context.trapBlock != NULL && context.trapBlock->getParent() == function) {
+        return context.trapBlock;
+    }
+
+    context.trapBlock = BasicBlock::Create(context.llvmContext, BRANCH_TRAP, function);
+    IRBuilder<> trapBuilder(context.trapBlock);
+    trapBuilder.CreateCall(Intrinsic::getDeclaration(context.module, Intrinsic::trap));
+    trapBuilder.CreateUnreachable();
+
+    return context.trapBlock;
+}
+
+/* Trap unless the index is within the bounds of the provided global array. The
+   branch is tagged, so that BoundsCheckHoisting can find it (see bounds-check.cpp).
+   Negative indexes wrap around to large unsigned values and fail the check. */
+static void checkArrayIndex(CompileContext& context, Value* array, Value* index) {
+    ArrayType* arrayType = dyn_cast<ArrayType>(cast<PointerType>(array->getType())->getElementType());
+    if (arrayType == NULL) {
+        return;
+    }
+
+    Value* size = ConstantInt::get(index->getType(), arrayType->getNumElements());
+    Value* inBounds = context.builder.CreateICmpULT(index, size, "inbounds");
+
+    Function* function = context.builder.GetInsertBlock()->getParent();
+    BasicBlock* inBoundsBlock = BasicBlock::Create(context.llvmContext, BRANCH_INBOUNDS, function);
+    BranchInst* check = context.builder.CreateCondBr(inBounds, inBoundsBlock, getTrapBlock(context));
+    check->setMetadata(BOUNDS_CHECK_METADATA, MDNode::get(context.llvmContext, ArrayRef<Value*>()));
+
+    context.builder.SetInsertPoint(inBoundsBlock);
+    sealBlock(context, inBoundsBlock);
+}
+
 /* Assign the provided value to the array with the provided id and index. */
-Value* assignArrayIndex(char* id, Value* index, Value* value) {
-    Value* array = getValue(id);
+Value* assignArrayIndex(CompileContext& context, char* id, Value* index, Value* value) {
+    Value* array = getValue(context, id);
     if (array == NULL) {
+        throwError(ERROR_VARIABLE_UNDECLARED, EXIT_VARIABLE_UNDECLARED);
+    }
+
+    if (isBoundsCheckEnabled()) {
+        checkArrayIndex(context, array, index);
     }
 
     // Get array location.
-    Value* arrayLoc = irBuilder->CreateStructGEP(array, 0, "arrayloc");
+    Value* arrayLoc = context.builder.CreateStructGEP(array, 0, "arrayloc");
 
     // Get location of array index.
-    Value* arrayIndex = irBuilder->CreateGEP(arrayLoc, index, "arrayindex");
+    Value* arrayIndex = context.builder.CreateGEP(arrayLoc, index, "arrayindex");
 
     // Store the provided value at the location of the array index.
-    return irBuilder->CreateStore(value, arrayIndex);
+    return context.builder.CreateStore(value, arrayIndex);
 }
 
 /* Access the array with the provided id at the provided index. */
-Value* accessArrayIndex(char* id, Value* index) {
-    Value* array = getValue(id);
+Value* accessArrayIndex(CompileContext& context, char* id, Value* index) {
+    Value* array = getValue(context, id);
     if (array == NULL) {
         throwError(ERROR_VARIABLE_UNDECLARED, EXIT_VARIABLE_UNDECLARED);
     }
 
+    if (isBoundsCheckEnabled()) {
+        checkArrayIndex(context, array, index);
+    }
+
     // Get array location.
-    Value* arrayLoc = irBuilder->CreateStructGEP(array, 0, "arrayloc");
+    Value* arrayLoc = context.builder.CreateStructGEP(array, 0, "arrayloc");
 
     // Get location of array index.
-    Value* arrayIndex = irBuilder->CreateGEP(arrayLoc, index, "arrayindex");
+    Value* arrayIndex = context.builder.CreateGEP(arrayLoc, index, "arrayindex");
 
     // Store results in temporary variable, and return it for use.
-    return irBuilder->CreateLoad(arrayIndex, "arrayval");
+    return context.builder.CreateLoad(arrayIndex, "arrayval");
 }
 
 /* Declare a variable with the provided type and id. */
-Value* declareVariable(Type* type, char* id) {
-    Value* variable = irBuilder->CreateAlloca(type, 0, id);
-    insertSymbol(id, variable);
+Value* declareVariable(CompileContext& context, Type* type, char* id) {
+    Value* variable = createLocalVariable(context, type, id);
+    insertSymbol(context, id, variable);
     return variable;
 }
 
 /* Assign the variable with the provided id with the provided value. */
-Value* assignVariable(char* id, Value* value) {
-    Value* variable = getValue(id);
+Value* assignVariable(CompileContext& context, char* id, Value* value) {
+    Value* variable = getValue(context, id);
     if (variable == NULL) {
         throwError(ERROR_VARIABLE_UNDECLARED, EXIT_VARIABLE_UNDECLARED);
     }
@@ -197,34 +240,59 @@ Value* assignVariable(char* id, Value* value) {
     Type* variableType = variable->getType()->getContainedType(0);
     Type* valueType = value->getType();
     if (variableType != valueType) {
-        if (valueType == getLLVMType(VALUE_VOIDTYPE)) { // Value is of type void (badref).
+        if (valueType == getLLVMType(context, TYPE_VOID)) { // Value is of type void (badref).
             throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
-        } else if (variableType == getLLVMType(VALUE_INTTYPE)) { // Variable is an integer, but value is a boolean.
+        } else if (variableType == getLLVMType(context, TYPE_INT)) { // Variable is an integer, but value is a boolean.
             throwError(ERROR_BOOL_TO_INT, EXIT_ASSIGN_TYPE_MISMATCH);
-        } else if (variableType == getLLVMType(VALUE_BOOLTYPE)) { // Variable is a boolean, but value is an integer.
+        } else if (variableType == getLLVMType(context, TYPE_BOOL)) { // Variable is a boolean, but value is an integer.
             throwError(ERROR_INT_TO_BOOL, EXIT_ASSIGN_TYPE_MISMATCH);
         } else {
             throw runtime_error("Type mismatch.\n");
         }
     }
 
-    return irBuilder->CreateStore(value, variable);
+    if (isLocalVariable(variable)) {
+        writeVariable(context, cast<AllocaInst>(variable), context.builder.GetInsertBlock(), value);
+        return value;
+    }
+
+    return context.builder.CreateStore(value, variable);
 }
 
 /* Access the variable with the provided id. */
-Value* accessVariable(char* id) {
-    Value* value = getValue(id);
+Value* accessVariable(CompileContext& context, char* id) {
+    Value* value = getValue(context, id);
     if (value == NULL) {
         throwError(ERROR_VARIABLE_UNDECLARED, EXIT_VARIABLE_UNDECLARED);
     }
 
-    return irBuilder->CreateLoad(value, false, id);
+    if (isLocalVariable(value)) {
+        return readVariable(context, cast<AllocaInst>(value), context.builder.GetInsertBlock());
+    }
+
+    return context.builder.CreateLoad(value, false, id);
+}
+
+/* Return the length of the string constant if the call prints one with the
+   print_string extern, or -1 otherwise. */
+static int getPrintedStringLength(Function* function, vector<Value*>& args) {
+    FunctionType* type = function->getFunctionType();
+    if (function->getName() != PRINT_STRING_FUNCTION || !function->isDeclaration() || type->getNumParams() != 1
+        || !type->getParamType(0)->isPointerTy()) {
+        return -1;
+    }
+
+    StringRef str;
+    if (!getConstantStringInfo(args[0], str)) {
+        return -1;
+    }
+    return str.size();
 }
 
 /* Call the function with the provided id, using the providing parameters. */
-Value* callFunction(char* id, vector<Value*>* args) {
+Value* callFunction(CompileContext& context, char* id, vector<Value*>* args) {
     // Ensure function exists within scope.
-    Function* function = (Function*) getValue(id);
+    Function* function = (Function*) getValue(context, id);
     if (function == NULL) {
         throw runtime_error("Function " + string(id) + " not found.\n");
     }
@@ -241,12 +309,12 @@ Value* callFunction(char* id, vector<Value*>* args) {
         Argument* param = paramIt;
         Value* arg = args->at(i);
 
-        if (arg->getType() == getLLVMType(VALUE_VOIDTYPE)) {
+        if (arg->getType() == getLLVMType(context, TYPE_VOID)) {
             throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
         }
         
-        if (param->getType() == getLLVMType(VALUE_INTTYPE) && arg->getType() == getLLVMType(VALUE_BOOLTYPE)) {
-            Value* convertedArg = convertBoolToInt(arg);
+        if (param->getType() == getLLVMType(context, TYPE_INT) && arg->getType() == getLLVMType(context, TYPE_BOOL)) {
+            Value* convertedArg = convertBoolToInt(context, arg);
             convertedArgs.push_back(convertedArg);
         } else {
             convertedArgs.push_back(arg);
@@ -256,82 +324,107 @@ Value* callFunction(char* id, vector<Value*>* args) {
     }
 
     
+    // Printing a string constant passes its length, so that the runtime does not
+    // measure the string on every call (decaf_print_string in decaf-stdlib.c).
+    int printedLength = getPrintedStringLength(function, convertedArgs);
+    if (printedLength >= 0) {
+        Type* paramTypes[] = { function->getFunctionType()->getParamType(0), getLLVMType(context, TYPE_INT) };
+        FunctionType* printType = FunctionType::get(getLLVMType(context, TYPE_VOID), paramTypes, false);
+        Constant* print = context.module->getOrInsertFunction(PRINT_STRING_LENGTH_FUNCTION, printType);
+        return context.builder.CreateCall2(print, convertedArgs[0], context.builder.getInt32(printedLength));
+    }
+
     Value* returnValue;
     // Do not assign a temporary variable (twine) when return type is void.
-    if (function->getReturnType() == getLLVMType(VALUE_VOIDTYPE)) {
-       returnValue = irBuilder->CreateCall(function, convertedArgs);
+    if (function->getReturnType() == getLLVMType(context, TYPE_VOID)) {
+       returnValue = context.builder.CreateCall(function, convertedArgs);
     } else {
-       returnValue = CallInst::Create(function, convertedArgs, "calltmp", irBuilder->GetInsertBlock());
+       returnValue = context.builder.CreateCall(function, convertedArgs, "calltmp");
     }
 
     return returnValue;
 }
 
-/* Create a store value for the provided parameter, as well as store in the symbol table. */
-Value* storeParameter(Type* type, char* id, Argument* parameter) {
-    // Allocate pointer
-    Value* allocVal = irBuilder->CreateAlloca(type, 0, id);
-    
-    // Store argument in pointer
-    irBuilder->CreateStore(parameter, allocVal);
-    insertSymbol(id, allocVal);
+/* Create a variable for the provided parameter holding its value, as well as store in the symbol table. */
+Value* storeParameter(CompileContext& context, Type* type, char* id, Argument* parameter) {
+    AllocaInst* variable = createLocalVariable(context, type, id);
+    if (isLocalVariable(variable)) {
+        writeVariable(context, variable, context.builder.GetInsertBlock(), parameter);
+    } else {
+        context.builder.CreateStore(parameter, variable);
+    }
+    insertSymbol(context, id, variable);
 
-    return allocVal;
+    return variable;
 }
 
 // Perform the operation on the provided left and right values.
-Value* computeBinaryExpression(char* op, Value* leftValue, Value* rightValue) {
+Value* computeBinaryExpression(CompileContext& context, DecafBinaryOp op, Value* leftValue, Value* rightValue) {
     Value* value;
 
-    if (strcmp(op, VALUE_EQ) == 0) {
-        validateBothSameType(leftValue, rightValue);
-        value = irBuilder->CreateICmpEQ(leftValue, rightValue, "eqtmp");
-    } else if (strcmp(op, VALUE_NEQ) == 0) {
-        validateBothSameType(leftValue, rightValue);
-        value = irBuilder->CreateICmpNE(leftValue, rightValue, "neq");
-    } else if (strcmp(op, VALUE_LT) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateICmpSLT(leftValue, rightValue, "lttmp");
-    } else if (strcmp(op, VALUE_LEQ) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateICmpSLE(leftValue, rightValue, "leqtmp");
-    } else if (strcmp(op, VALUE_GT) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateICmpSGT(leftValue, rightValue, "gttmp");
-    } else if (strcmp(op, VALUE_GEQ) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateICmpSGE(leftValue, rightValue, "geqtmp");
-    } else if (strcmp(op, VALUE_PLUS) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateAdd(leftValue, rightValue, "addtmp");
-    } else if (strcmp(op, VALUE_MINUS) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateSub(leftValue, rightValue, "subtmp");
-    } else if (strcmp(op, VALUE_MULT) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateMul(leftValue, rightValue, "multmp");
-    } else if (strcmp(op, VALUE_DIV) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateSDiv(leftValue, rightValue, "divtmp");
-    } else if (strcmp(op, VALUE_MOD) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateSRem(leftValue, rightValue, "modtmp");
-    } else if (strcmp(op, VALUE_RIGHTSHIFT) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateAShr(leftValue, rightValue, "rshifttmp");
-    } else if (strcmp(op, VALUE_LEFTSHIFT) == 0) {
-        validateBothIntType(leftValue, rightValue);
-        value = irBuilder->CreateShl(leftValue, rightValue, "lshifttmp");
-    } else {
-        throw runtime_error("Invalid binary operation.\n");
+    switch (op) {
+        case OP_EQ:
+            validateBothSameType(leftValue, rightValue);
+            value = context.builder.CreateICmpEQ(leftValue, rightValue, "eqtmp");
+            break;
+        case OP_NEQ:
+            validateBothSameType(leftValue, rightValue);
+            value = context.builder.CreateICmpNE(leftValue, rightValue, "neq");
+            break;
+        case OP_LT:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateICmpSLT(leftValue, rightValue, "lttmp");
+            break;
+        case OP_LEQ:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateICmpSLE(leftValue, rightValue, "leqtmp");
+            break;
+        case OP_GT:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateICmpSGT(leftValue, rightValue, "gttmp");
+            break;
+        case OP_GEQ:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateICmpSGE(leftValue, rightValue, "geqtmp");
+            break;
+        case OP_PLUS:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateAdd(leftValue, rightValue, "addtmp");
+            break;
+        case OP_MINUS:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateSub(leftValue, rightValue, "subtmp");
+            break;
+        case OP_MULT:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateMul(leftValue, rightValue, "multmp");
+            break;
+        case OP_DIV:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateSDiv(leftValue, rightValue, "divtmp");
+            break;
+        case OP_MOD:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateSRem(leftValue, rightValue, "modtmp");
+            break;
+        case OP_RIGHTSHIFT:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateAShr(leftValue, rightValue, "rshifttmp");
+            break;
+        case OP_LEFTSHIFT:
+            validateBothIntType(context, leftValue, rightValue);
+            value = context.builder.CreateShl(leftValue, rightValue, "lshifttmp");
+            break;
+        default:
+            throw runtime_error("Invalid binary operation.\n");
     }
 
     return value;
 }
 
 // Ensure both values are of int type.
-void validateBothIntType(Value* leftValue, Value* rightValue) {
-    Type* intType = getLLVMType(VALUE_INTTYPE); 
+void validateBothIntType(CompileContext& context, Value* leftValue, Value* rightValue) {
+    Type* intType = getLLVMType(context, TYPE_INT); 
     Type* leftType = leftValue->getType();
     Type* rightType = rightValue->getType();
     
@@ -340,13 +433,9 @@ void validateBothIntType(Value* leftValue, Value* rightValue) {
     }
 }
 
-// Ensure both values are of bool type.
-void validateBothBoolType(Value* leftValue, Value* rightValue) {
-    Type* boolType = getLLVMType(VALUE_BOOLTYPE);
-    Type* leftType = leftValue->getType();
-    Type* rightType = rightValue->getType();
-    
-    if (leftType != boolType || rightType != boolType) {
+// Ensure the value is of bool type.
+void validateBoolType(CompileContext& context, Value* value) {
+    if (value->getType() != getLLVMType(context, TYPE_BOOL)) {
         throwError(ERROR_INVALID_BOOL_OP, EXIT_COMPUTE_TYPE_MISMATCH);
     }
 }
@@ -362,26 +451,29 @@ void validateBothSameType(Value* leftValue, Value* rightValue) {
 }
 
 // Perform the operation on the provided value.
-Value* computeUnaryExpression(char* op, Value* value) {
+Value* computeUnaryExpression(CompileContext& context, DecafUnaryOp op, Value* value) {
     Type* valueType = value->getType();
     // Ensure argument is not void (badref).
-    if (valueType == getLLVMType(VALUE_VOIDTYPE)) {
+    if (valueType == getLLVMType(context, TYPE_VOID)) {
         throwError(ERROR_FUNCTION_IS_VOID, EXIT_ERROR);
     }
 
     Value* returnValue;
-    if (strcmp(op, VALUE_NOT) == 0) {
-        if (valueType == getLLVMType(VALUE_INTTYPE)) {
-            throwError(ERROR_NOT_INT, EXIT_COMPUTE_TYPE_MISMATCH);
-        }
-        returnValue = irBuilder->CreateNot(value, "nottmp");
-    } else if (strcmp(op, VALUE_NEGATE) == 0) {
-        if (valueType == getLLVMType(VALUE_BOOLTYPE)) {
-            throwError(ERROR_NEGATE_BOOL, EXIT_COMPUTE_TYPE_MISMATCH);
-        }
-        returnValue = irBuilder->CreateSub(irBuilder->getInt32(0), value, "negtmp");
-    } else {
-        throw runtime_error("Invalid unary operation\n");
+    switch (op) {
+        case OP_NOT:
+            if (valueType == getLLVMType(context, TYPE_INT)) {
+                throwError(ERROR_NOT_INT, EXIT_COMPUTE_TYPE_MISMATCH);
+            }
+            returnValue = context.builder.CreateNot(value, "nottmp");
+            break;
+        case OP_NEGATE:
+            if (valueType == getLLVMType(context, TYPE_BOOL)) {
+                throwError(ERROR_NEGATE_BOOL, EXIT_COMPUTE_TYPE_MISMATCH);
+            }
+            returnValue = context.builder.CreateSub(context.builder.getInt32(0), value, "negtmp");
+            break;
+        default:
+            throw runtime_error("Invalid unary operation\n");
     }
 
     return returnValue;
@@ -5,6 +5,8 @@
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
 #include "llvm/PassManager.h"
+#include "compile-context.h"
+#include "expr-asts.h"
 #include "value-constants.h"
 #include <stdexcept>
 #include <string>
@@ -21,35 +23,34 @@ extern const char* BRANCH_BODY;
 extern const char* BRANCH_NEXT;
 extern const char* BRANCH_NOSKCT;
 extern const char* BRANCH_SKCTEND;
-extern const char* BRANCH_IFSTART;
 extern const char* BRANCH_IFTRUE;
 extern const char* BRANCH_IFFALSE;
+extern const char* BRANCH_INBOUNDS;
+extern const char* BRANCH_TRAP;
 
 
 void initializeLLVM();
-Module* getModule();
-IRBuilder<>* getBuilder();
-Type* getLLVMType(const char* typeStr);
-Value* createDefaultReturn(Type* type);
-Value* getIntConstant(int value);
-Value* getBoolConstant(bool value);
-Value* convertBoolToInt(Value* value);
-Function* createExternFunction(Type* returnType, char* id, vector<Type*>* parameterTypes);
-Function* createFunctionHeader(Type* returnType, char* id);
-Value* createString(const char* str);
-Value* createArray(Type* type, char* id, int size);
-Value* createGlobalScalar(Type* type, char* id, Constant* value);
-Value* assignArrayIndex(char* id, Value* index, Value* value);
-Value* accessArrayIndex(char* id, Value* index);
-Value* declareVariable(Type* type, char* id);
-Value* assignVariable(char* id, Value* value);
-Value* accessVariable(char* id);
-Value* callFunction(char* id, vector<Value*>* args);
-Value* storeParameter(Type* type, char* id, Argument* parameter);
-Value* computeBinaryExpression(char* op, Value* leftValue, Value* rightValue);
-void validateBothIntType(Value* leftValue, Value* rightValue);
-void validateBothBoolType(Value* leftValue, Value* rightValue);
+Type* getLLVMType(CompileContext& context, DecafType decafType);
+Value* createDefaultReturn(CompileContext& context, Type* type);
+Value* getIntConstant(CompileContext& context, int value);
+Value* getBoolConstant(CompileContext& context, bool value);
+Value* convertBoolToInt(CompileContext& context, Value* value);
+Function* createExternFunction(CompileContext& context, Type* returnType, char* id, TypeList* parameterTypes);
+Function* createFunctionHeader(CompileContext& context, Type* returnType, char* id, vector<Type*>& paramTypes);
+Value* createString(CompileContext& context, const char* str);
+Value* createArray(CompileContext& context, Type* type, char* id, int size);
+Value* createGlobalScalar(CompileContext& context, Type* type, char* id, Constant* value);
+Value* assignArrayIndex(CompileContext& context, char* id, Value* index, Value* value);
+Value* accessArrayIndex(CompileContext& context, char* id, Value* index);
+Value* declareVariable(CompileContext& context, Type* type, char* id);
+Value* assignVariable(CompileContext& context, char* id, Value* value);
+Value* accessVariable(CompileContext& context, char* id);
+Value* callFunction(CompileContext& context, char* id, vector<Value*>* args);
+Value* storeParameter(CompileContext& context, Type* type, char* id, Argument* parameter);
+Value* computeBinaryExpression(CompileContext& context, DecafBinaryOp op, Value* leftValue, Value* rightValue);
+void validateBothIntType(CompileContext& context, Value* leftValue, Value* rightValue);
+void validateBoolType(CompileContext& context, Value* value);
 void validateBothSameType(Value* leftValue, Value* rightValue);
-Value* computeUnaryExpression(char* op, Value* value);
+Value* computeUnaryExpression(CompileContext& context, DecafUnaryOp op, Value* value);
 
 #endif
@@ -0,0 +1,262 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/InstIterator.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+#include "compile-options.h"
+#include "llvm-target.h"
+#include "llvm-util.h"
+#include "method-cache.h"
+#include "symbol-table.h"
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+const uint64_t FNV_PRIME = 1099511628211ULL;
+// Bumped whenever code generation changes, so stale entries are never reused.
+const int CACHE_FORMAT_VERSION = 4;
+const char* CACHE_FILE_SUFFIX = ".bc";
+const char* NO_SIGNATURE = "none";
+
+AstHash::AstHash() {
+    value = FNV_OFFSET_BASIS;
+}
+
+void AstHash::addBytes(const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*) data;
+    for (size_t i = 0; i < length; i++) {
+        value = (value ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+void AstHash::addInt(int64_t number) {
+    addBytes(&number, sizeof(number));
+}
+
+/* Add the string including its terminator, so that adjacent strings cannot
+   run into each other. */
+void AstHash::addString(const char* str) {
+    addBytes(str, strlen(str) + 1);
+}
+
+/* Add the printed form of the type, which unlike the Type pointer is the same
+   in every compile. A NULL type is added as "none". */
+void AstHash::addType(Type* type) {
+    string description;
+    raw_string_ostream stream(description);
+    if (type != NULL) {
+        type->print(stream);
+    } else {
+        stream << NO_SIGNATURE;
+    }
+    addString(stream.str().c_str());
+}
+
+void AstHash::addList(ExprList* list) {
+    addInt(list->size());
+    for (ExprList::iterator it = list->begin(); it != list->end(); it++) {
+        (*it)->hashNode(*this);
+    }
+}
+
+void AstHash::addReference(char* id) {
+    addString(id);
+    references.push_back(id);
+}
+
+uint64_t AstHash::getValue() {
+    return value;
+}
+
+vector<char*>& AstHash::getReferences() {
+    return references;
+}
+
+/* Return the key of the method: its normalized AST, the signatures of the fields,
+   methods and externs it references and the options that change its optimized
+   body. Must be called with the class scope innermost, before the method scope
+   is pushed, so that every reference resolves to its class level binding (or to
+   nothing, for locals). Locals shadowing a field only make the key stricter. */
+string getMethodCacheKey(CompileContext& context, FunctionExprAst* method) {
+    AstHash hash;
+    hash.addInt(CACHE_FORMAT_VERSION);
+    hash.addInt(getOptimizationLevel());
+    hash.addInt(isBoundsCheckEnabled());
+    hash.addInt(isDirectSsaEnabled());
+    hash.addInt(isMethodInstrumentationEnabled());
+    hash.addString(context.module->getDataLayout().c_str());
+    hash.addString(getTargetMachine()->getTargetCPU().str().c_str());
+    hash.addString(getTargetMachine()->getTargetFeatureString().str().c_str());
+    method->hashNode(hash);
+
+    // Identifiers are interned, so duplicates share an address.
+    vector<char*>& references = hash.getReferences();
+    set<char*> seen;
+    for (size_t i = 0; i < references.size(); i++) {
+        char* id = references[i];
+        if (seen.insert(id).second) {
+            Value* value = getValue(context, id);
+            hash.addString(id);
+            hash.addType(value != NULL ? value->getType() : NULL);
+        }
+    }
+
+    char key[2 * sizeof(uint64_t) + 1];
+    snprintf(key, sizeof(key), "%016llx", (unsigned long long) hash.getValue());
+    return key;
+}
+
+/* Return the path of the cache entry with the provided key. */
+static string getCachePath(const string& key) {
+    return string(getCacheDirectory()) + "/" + key + CACHE_FILE_SUFFIX;
+}
+
+/* Add the globals used by the value, looking through constant expressions such
+   as the GEP of a string constant. */
+static void collectGlobals(Value* value, SetVector<GlobalValue*>& globals) {
+    if (GlobalValue* global = dyn_cast<GlobalValue>(value)) {
+        globals.insert(global);
+    } else if (ConstantExpr* expr = dyn_cast<ConstantExpr>(value)) {
+        for (unsigned i = 0; i < expr->getNumOperands(); i++) {
+            collectGlobals(expr->getOperand(i), globals);
+        }
+    }
+}
+
+/* Return the counterpart of the global in the provided module. String constants
+   are private to the method that uses them, so they are copied along with its
+   body, while fields, methods, externs and intrinsics are matched by name and
+   declared if the module does not have them yet. */
+static GlobalValue* mapGlobal(GlobalValue* global, Module* module) {
+    if (Function* function = dyn_cast<Function>(global)) {
+        Function* existing = module->getFunction(function->getName());
+        if (existing != NULL) {
+            return existing;
+        }
+
+        Function* declaration = Function::Create(function->getFunctionType(), GlobalValue::ExternalLinkage,
+                                                 function->getName(), module);
+        declaration->copyAttributesFrom(function);
+        return declaration;
+    }
+
+    GlobalVariable* variable = cast<GlobalVariable>(global);
+    Type* type = variable->getType()->getElementType();
+    if (variable->hasLocalLinkage() && variable->hasInitializer()) {
+        GlobalVariable* copy = new GlobalVariable(*module, type, variable->isConstant(), variable->getLinkage(),
+                                                  variable->getInitializer(), variable->getName());
+        copy->copyAttributesFrom(variable);
+        return copy;
+    }
+
+    GlobalVariable* existing = module->getGlobalVariable(variable->getName());
+    if (existing != NULL) {
+        return existing;
+    }
+
+    return new GlobalVariable(*module, type, variable->isConstant(), GlobalValue::ExternalLinkage, NULL,
+                              variable->getName());
+}
+
+/* Copy the body of the source method into the empty target method, which may be
+   in another module, remapping the globals it uses to those of the target module. */
+static void cloneMethodBody(Function* source, Function* target) {
+    ValueToValueMapTy valueMap;
+    valueMap[source] = target;
+
+    Function::arg_iterator targetArg = target->arg_begin();
+    for (Function::arg_iterator it = source->arg_begin(); it != source->arg_end(); it++, targetArg++) {
+        targetArg->setName(it->getName());
+        valueMap[it] = targetArg;
+    }
+
+    SetVector<GlobalValue*> globals;
+    for (inst_iterator it = inst_begin(source); it != inst_end(source); it++) {
+        for (unsigned i = 0; i < it->getNumOperands(); i++) {
+            collectGlobals(it->getOperand(i), globals);
+        }
+    }
+    for (SetVector<GlobalValue*>::iterator it = globals.begin(); it != globals.end(); it++) {
+        if (*it != source) {
+            valueMap[*it] = mapGlobal(*it, target->getParent());
+        }
+    }
+
+    SmallVector<ReturnInst*, 4> returns;
+    CloneFunctionInto(target, source, valueMap, true, returns);
+}
+
+/* Replace the (still empty) body of the method with the optimized body cached
+   under the key, returning false if there is no usable entry. */
+bool loadCachedMethod(CompileContext& context, Function* function, const string& key) {
+    OwningPtr<MemoryBuffer> buffer;
+    if (MemoryBuffer::getFile(getCachePath(key), buffer)) {
+        return false;
+    }
+
+    string errorInfo;
+    Module* cached = ParseBitcodeFile(buffer.get(), context.llvmContext, &errorInfo);
+    if (cached == NULL) {
+        return false;
+    }
+
+    Function* source = cached->getFunction(function->getName());
+    bool usable = (source != NULL && !source->isDeclaration() && source->getFunctionType() == function->getFunctionType());
+    if (usable) {
+        // Drop the entry block created along with the header.
+        while (!function->empty()) {
+            function->begin()->eraseFromParent();
+        }
+        cloneMethodBody(source, function);
+    }
+
+    delete cached;
+    return usable;
+}
+
+/* Write the optimized method, with declarations of everything it references, to
+   the cache entry of the key. The cache is best effort, so failures are ignored. */
+void storeCachedMethod(CompileContext& context, Function* function, const string& key) {
+    Module cached(MODULE_NAME, context.llvmContext);
+    Function* copy = Function::Create(function->getFunctionType(), GlobalValue::ExternalLinkage,
+                                      function->getName(), &cached);
+    cloneMethodBody(function, copy);
+
+    // Entries are written under a private name and renamed into place, so that
+    // concurrent compiles (-jobs workers, servers) never read a partial entry.
+    string path = getCachePath(key);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", (int) getpid());
+    string tempPath = path + suffix;
+
+    mkdir(getCacheDirectory(), 0777);
+    string errorInfo;
+    raw_fd_ostream output(tempPath.c_str(), errorInfo, raw_fd_ostream::F_Binary);
+    if (!errorInfo.empty()) {
+        return;
+    }
+
+    WriteBitcodeToFile(&cached, output);
+    output.close();
+    if (output.has_error()) {
+        output.clear_error();
+        unlink(tempPath.c_str());
+    } else if (rename(tempPath.c_str(), path.c_str()) != 0) {
+        unlink(tempPath.c_str());
+    }
+}
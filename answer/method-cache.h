@@ -0,0 +1,38 @@
+#ifndef METHOD_CACHE_H
+#define METHOD_CACHE_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Type.h"
+#include "compile-context.h"
+#include "expr-asts.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+// AstHash - 64 bit FNV-1a hash of a normalized AST, built by ExprAst::hashNode from
+// the node kinds, types, operators, identifiers and constants in tree order, so
+// layout and comments do not change it. Identifiers that may name a field,
+// method or extern are also collected, so that the key can include their signatures.
+class AstHash {
+    uint64_t value;
+    vector<char*> references;
+public:
+    AstHash();
+    void addBytes(const void* data, size_t length);
+    void addInt(int64_t number);
+    void addString(const char* str);
+    void addType(Type* type);
+    void addList(ExprList* list);
+    void addReference(char* id);
+    uint64_t getValue();
+    vector<char*>& getReferences();
+};
+
+string getMethodCacheKey(CompileContext& context, FunctionExprAst* method);
+bool loadCachedMethod(CompileContext& context, Function* function, const string& key);
+void storeCachedMethod(CompileContext& context, Function* function, const string& key);
+
+#endif
@@ -0,0 +1,77 @@
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "method-profiler.h"
+
+using namespace llvm;
+
+const char* METHOD_ENTER_FUNCTION = "decaf_method_enter";
+const char* METHOD_EXIT_FUNCTION = "decaf_method_exit";
+const char* METHOD_RECORD_PREFIX = "decaf.method.";
+
+/* Return the hook of the runtime with the provided name, void (i8* record). */
+static Constant* getHook(Module* module, const char* name) {
+    LLVMContext& llvmContext = module->getContext();
+    Type* paramTypes[] = { Type::getInt8PtrTy(llvmContext) };
+    FunctionType* type = FunctionType::get(Type::getVoidTy(llvmContext), paramTypes, false);
+    return module->getOrInsertFunction(name, type);
+}
+
+/* Create the record the runtime keeps the counts of the method in, matching
+   struct decaf_method_record in decaf-stdlib.c: the call count, inclusive and
+   exclusive cycles, the link to the next entered method, the number of active
+   calls and the name. The name is stored inline rather than pointed to, so that
+   cached bodies (-cache-dir) may copy the record to another module. */
+static GlobalVariable* createRecord(Module* module, Function* function) {
+    LLVMContext& llvmContext = module->getContext();
+    Type* countType = Type::getInt64Ty(llvmContext);
+    PointerType* nextType = Type::getInt8PtrTy(llvmContext);
+    Type* activeType = Type::getInt32Ty(llvmContext);
+    Constant* name = ConstantDataArray::getString(llvmContext, function->getName());
+    StructType* recordType = StructType::get(countType, countType, countType, nextType, activeType, name->getType(),
+                                             NULL);
+
+    Constant* zeroCount = ConstantInt::get(countType, 0);
+    Constant* fields[] = {
+        zeroCount, zeroCount, zeroCount, ConstantPointerNull::get(nextType), ConstantInt::get(activeType, 0), name
+    };
+    Constant* record = ConstantStruct::get(recordType, fields);
+    return new GlobalVariable(*module, recordType, false, GlobalValue::InternalLinkage, record,
+                              Twine(METHOD_RECORD_PREFIX) + function->getName());
+}
+
+/* Call the entry hook of the runtime when the optimized method is entered and
+   the exit hook before each of its returns, which count the calls and the
+   inclusive and exclusive rdtsc cycles of the method and its callers
+   (-finstrument-methods). Running after the function passes keeps the hooks out
+   of loops that tail call elimination made of recursion, and inlined methods
+   take their hooks along, so their time is still their own. */
+void instrumentMethod(CompileContext& context, Function* function) {
+    Module* module = context.module;
+    Value* record = ConstantExpr::getBitCast(createRecord(module, function), Type::getInt8PtrTy(context.llvmContext));
+
+    BasicBlock& entryBlock = function->getEntryBlock();
+    BasicBlock::iterator entryPoint = entryBlock.begin();
+    while (isa<AllocaInst>(entryPoint)) {
+        entryPoint++;
+    }
+    IRBuilder<> entryBuilder(&entryBlock, entryPoint);
+    entryBuilder.CreateCall(getHook(module, METHOD_ENTER_FUNCTION), record);
+
+    SmallVector<ReturnInst*, 4> returns;
+    for (Function::iterator it = function->begin(); it != function->end(); it++) {
+        if (ReturnInst* ret = dyn_cast<ReturnInst>(it->getTerminator())) {
+            returns.push_back(ret);
+        }
+    }
+    for (size_t i = 0; i < returns.size(); i++) {
+        IRBuilder<> builder(returns[i]);
+        builder.CreateCall(getHook(module, METHOD_EXIT_FUNCTION), record);
+    }
+}
@@ -0,0 +1,11 @@
+#ifndef METHOD_PROFILER_H
+#define METHOD_PROFILER_H
+
+#include "llvm/IR/Function.h"
+#include "compile-context.h"
+
+using namespace llvm;
+
+void instrumentMethod(CompileContext& context, Function* function);
+
+#endif
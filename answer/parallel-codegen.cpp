@@ -0,0 +1,222 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Linker.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/system_error.h"
+#include "compile-context.h"
+#include "compile-error.h"
+#include "debug-info.h"
+#include "llvm-emit.h"
+#include "llvm-util.h"
+#include "parallel-codegen.h"
+#include "value-constants.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+const char* SHARD_FILE_TEMPLATE = "/tmp/decaf-shard-XXXXXX";
+const int PIPE_BUFFER_SIZE = 256;
+
+// Worker - A forked process generating every jobs-th method body into a
+// bitcode shard, reporting compile errors through a pipe.
+struct Worker {
+    pid_t pid;
+    int errorPipe;
+    string shardFile;
+};
+
+/* Generate the bodies of the methods assigned to the worker and write them to
+   its shard. Runs in the forked worker and never returns. */
+static void runWorker(CompileContext& context, int index, int jobs, const char* shardFile, int errorPipe) {
+    deque<FunctionExprAst*>& functions = context.functionList;
+    Module* module = context.module;
+    int status = EXIT_NO_ERROR;
+
+    // Report errors through the pipe rather than exiting through the parent's
+    // exit handlers.
+    setRecoverableErrors(true);
+
+    try {
+        // Fields are defined by the parent module, shards only reference them.
+        for (Module::global_iterator it = module->global_begin(); it != module->global_end(); it++) {
+            it->setInitializer(NULL);
+        }
+
+        // The linker never resolves against internal symbols, so every method
+        // is external, whether it is defined here or by another shard.
+        for (size_t i = 0; i < functions.size(); i++) {
+            Function* function = functions[i]->getFunction();
+            function->setLinkage(GlobalValue::ExternalLinkage);
+            if ((int) (i % jobs) == index) {
+                functions[i]->generateDeferedCode(context);
+            } else {
+                function->deleteBody();
+            }
+        }
+
+        detachDebugInfo(context);
+        writeBitcode(module, shardFile);
+    } catch (CompileError& error) {
+        status = error.getCode();
+        write(errorPipe, error.what(), strlen(error.what()));
+    } catch (exception& error) {
+        status = EXIT_ERROR;
+        write(errorPipe, error.what(), strlen(error.what()));
+    }
+
+    // Skip exit handlers, the worker shares them with the parent.
+    _exit(status);
+}
+
+/* Fork a worker for the provided shard index. */
+static Worker startWorker(CompileContext& context, int index, int jobs) {
+    Worker worker;
+    vector<char> shardFile(SHARD_FILE_TEMPLATE, SHARD_FILE_TEMPLATE + strlen(SHARD_FILE_TEMPLATE) + 1);
+    int pipeEnds[2];
+
+    int shardFd = mkstemp(&shardFile[0]);
+    if (shardFd < 0 || pipe(pipeEnds) != 0) {
+        throw runtime_error("Could not create a code generation worker.\n");
+    }
+    close(shardFd);
+
+    worker.shardFile = &shardFile[0];
+    worker.pid = fork();
+    if (worker.pid < 0) {
+        throw runtime_error("Could not create a code generation worker.\n");
+    } else if (worker.pid == 0) {
+        close(pipeEnds[0]);
+        runWorker(context, index, jobs, &shardFile[0], pipeEnds[1]);
+    }
+
+    close(pipeEnds[1]);
+    worker.errorPipe = pipeEnds[0];
+    return worker;
+}
+
+/* Wait for the worker to finish, returning its exit status and storing any
+   compile error it reported in the provided message. */
+static int finishWorker(Worker& worker, string& message) {
+    char buffer[PIPE_BUFFER_SIZE];
+    ssize_t length;
+
+    while ((length = read(worker.errorPipe, buffer, PIPE_BUFFER_SIZE)) > 0) {
+        message.append(buffer, length);
+    }
+    close(worker.errorPipe);
+
+    int status;
+    waitpid(worker.pid, &status, 0);
+    if (!WIFEXITED(status)) {
+        message = ERROR_WORKER_FAILED;
+        return EXIT_ERROR;
+    }
+
+    return WEXITSTATUS(status);
+}
+
+/* Read the bitcode shard written by a worker and link it into the module. */
+static void linkShard(Module* module, const string& shardFile) {
+    OwningPtr<MemoryBuffer> buffer;
+    string errorInfo = "unreadable bitcode";
+    Module* shard = NULL;
+
+    if (!MemoryBuffer::getFile(shardFile, buffer)) {
+        shard = ParseBitcodeFile(buffer.get(), module->getContext(), &errorInfo);
+    }
+    if (shard == NULL || Linker::LinkModules(module, shard, Linker::DestroySource, &errorInfo)) {
+        throw runtime_error("Could not link " + shardFile + ": " + errorInfo + "\n");
+    }
+
+    delete shard;
+}
+
+/* Delete the shard files of the workers. */
+static void removeShards(vector<Worker>& workers) {
+    for (size_t i = 0; i < workers.size(); i++) {
+        unlink(workers[i].shardFile.c_str());
+    }
+}
+
+/* Replace the (still empty) method bodies of the module with those generated
+   by the workers. The methods are external while the shards are linked, as the
+   linker would rename a definition instead of resolving an internal
+   declaration, and get their own linkage back once all shards are linked. */
+static void linkShards(CompileContext& context, vector<Worker>& workers) {
+    deque<FunctionExprAst*>& functions = context.functionList;
+    Module* module = context.module;
+    vector<string> names;
+    vector<GlobalValue::LinkageTypes> linkages;
+
+    for (size_t i = 0; i < functions.size(); i++) {
+        Function* function = functions[i]->getFunction();
+        names.push_back(function->getName());
+        linkages.push_back(function->getLinkage());
+        function->deleteBody();
+        function->setLinkage(GlobalValue::ExternalLinkage);
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        linkShard(module, workers[i].shardFile);
+    }
+
+    // Linking replaces the declarations, so look the methods up again.
+    for (size_t i = 0; i < names.size(); i++) {
+        module->getFunction(names[i])->setLinkage(linkages[i]);
+    }
+}
+
+/* Generate and optimize the deferred method bodies on the provided number of
+   worker processes, then link the resulting shards into the module. Workers are
+   forked processes, each with its own copy of the compile context, as a single
+   LLVM context may not be used by several threads.
+   The first compile error reported by a worker is raised through throwError. */
+void generateDeferedCodeParallel(CompileContext& context, int jobs) {
+    vector<Worker> workers;
+    string message;
+    int exitVal = EXIT_NO_ERROR;
+
+    // Buffered output would otherwise be written once more by every worker.
+    fflush(NULL);
+    for (int i = 0; i < jobs; i++) {
+        workers.push_back(startWorker(context, i, jobs));
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        string workerMessage;
+        int workerExitVal = finishWorker(workers[i], workerMessage);
+        if (workerExitVal != EXIT_NO_ERROR && exitVal == EXIT_NO_ERROR) {
+            exitVal = workerExitVal;
+            message = workerMessage;
+        }
+    }
+
+    try {
+        if (exitVal == EXIT_NO_ERROR) {
+            linkShards(context, workers);
+        }
+    } catch (...) {
+        removeShards(workers);
+        throw;
+    }
+    removeShards(workers);
+
+    // The worker reported its error through the pipe, raise it here.
+    if (exitVal != EXIT_NO_ERROR) {
+        throwError(message.c_str(), exitVal);
+    }
+}
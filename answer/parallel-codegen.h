@@ -0,0 +1,9 @@
+#ifndef PARALLEL_CODEGEN_H
+#define PARALLEL_CODEGEN_H
+
+#include "compile-context.h"
+#include "expr-asts.h"
+
+void generateDeferedCodeParallel(CompileContext& context, int jobs);
+
+#endif
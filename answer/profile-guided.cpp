@@ -0,0 +1,299 @@
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/Attributes.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/system_error.h"
+#include "compile-options.h"
+#include "profile-guided.h"
+#include "value-constants.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+/* The counters of a method are an array of 64 bit counts: its entry count, then
+   the true and false edge counts of each of its conditional branches, in block
+   order of the IR as generated (before any pass ran). The same IR is generated
+   for the same source and options, so -fprofile-use finds the branches at the
+   same positions; methods whose branch count changed are left unweighted. The
+   runtime (decaf_profile_start in decaf-stdlib.c) writes one line per method:
+   "NAME COUNT C0 C1 ...", after the PROFILE_HEADER line. */
+
+const char* PROFILE_HEADER = "decaf-profile 1\n";
+const char* PROFILE_COUNTERS_PREFIX = "decaf.profile.";
+const char* PROFILE_TABLE = "decaf.profile";
+const char* PROFILE_STRING = "decaf.profile_string";
+const char* PROFILE_START_FUNCTION = "decaf_profile_start";
+// Branch weights are 32 bit, larger counts are scaled down keeping their ratio.
+const uint64_t MAX_BRANCH_WEIGHT = 0xffffffffULL;
+// Methods entered at least 1/HOT_METHOD_DIVISOR as often as the hottest one are hot.
+const uint64_t HOT_METHOD_DIVISOR = 10;
+
+// Counts of the -fprofile-use profile by method, only read once loaded.
+static StringMap<vector<uint64_t> > profileCounts;
+static uint64_t maxEntryCount = 0;
+static bool profileLoaded = false;
+
+/* Read a count at the position, skipping the blanks before it. Returns false
+   if there is no number there. */
+static bool readCount(const char*& pos, uint64_t& count) {
+    char* end;
+    count = strtoull(pos, &end, 10);
+    if (end == pos) {
+        return false;
+    }
+
+    pos = end;
+    return true;
+}
+
+/* Parse the profile text into profileCounts, returning false if it is malformed. */
+static bool parseProfile(const char* text) {
+    if (strncmp(text, PROFILE_HEADER, strlen(PROFILE_HEADER)) != 0) {
+        return false;
+    }
+
+    const char* pos = text + strlen(PROFILE_HEADER);
+    while (true) {
+        while (*pos == ' ' || *pos == '\n') {
+            pos++;
+        }
+        if (*pos == '\0') {
+            return true;
+        }
+
+        const char* nameEnd = strchr(pos, ' ');
+        if (nameEnd == NULL) {
+            return false;
+        }
+        string name(pos, nameEnd);
+        pos = nameEnd;
+
+        uint64_t size;
+        if (!readCount(pos, size) || size == 0) {
+            return false;
+        }
+        vector<uint64_t> counts(size);
+        for (uint64_t i = 0; i < size; i++) {
+            if (!readCount(pos, counts[i])) {
+                return false;
+            }
+        }
+
+        maxEntryCount = max(maxEntryCount, counts[0]);
+        profileCounts[name] = counts;
+    }
+}
+
+/* Load the profile given to -fprofile-use, shared by every compile of the
+   process. Halts the program if it cannot be read. */
+void initializeProfile() {
+    if (getProfileMode() != PROFILE_USE || profileLoaded) {
+        return;
+    }
+
+    OwningPtr<MemoryBuffer> buffer;
+    if (MemoryBuffer::getFile(getProfileFile(), buffer) || !parseProfile(buffer->getBufferStart())) {
+        fprintf(stderr, "%s: ", getProfileFile());
+        throwError(ERROR_PROFILE_UNREADABLE, EXIT_ERROR);
+    }
+    profileLoaded = true;
+}
+
+/* Collect the conditional branches of the function in block order. */
+static void collectBranches(Function* function, vector<BranchInst*>& branches) {
+    for (Function::iterator it = function->begin(); it != function->end(); it++) {
+        BranchInst* branch = dyn_cast<BranchInst>(it->getTerminator());
+        if (branch != NULL && branch->isConditional()) {
+            branches.push_back(branch);
+        }
+    }
+}
+
+/* Add one to the counter at the index. */
+static void incrementCounter(IRBuilder<>& builder, GlobalVariable* counters, Value* index) {
+    Value* indexes[] = { builder.getInt64(0), index };
+    Value* counter = builder.CreateInBoundsGEP(counters, indexes, "counter");
+    Value* count = builder.CreateLoad(counter, "count");
+    builder.CreateStore(builder.CreateAdd(count, builder.getInt64(1)), counter);
+}
+
+/* Count the entries of the function and the edges taken by its conditional
+   branches, in a counter array named after it (-fprofile-generate). */
+static void instrumentFunction(CompileContext& context, Function* function) {
+    vector<BranchInst*> branches;
+    collectBranches(function, branches);
+
+    ArrayType* countersType = ArrayType::get(Type::getInt64Ty(context.llvmContext), 1 + 2 * branches.size());
+    GlobalVariable* counters = new GlobalVariable(*context.module, countersType, false, GlobalValue::InternalLinkage,
+                                                  Constant::getNullValue(countersType),
+                                                  Twine(PROFILE_COUNTERS_PREFIX) + function->getName());
+
+    // Count the entry after the allocas (-fno-direct-ssa), which must stay first.
+    BasicBlock& entryBlock = function->getEntryBlock();
+    BasicBlock::iterator entryPoint = entryBlock.begin();
+    while (isa<AllocaInst>(entryPoint)) {
+        entryPoint++;
+    }
+    IRBuilder<> entryBuilder(&entryBlock, entryPoint);
+    incrementCounter(entryBuilder, counters, entryBuilder.getInt64(0));
+
+    for (size_t i = 0; i < branches.size(); i++) {
+        BranchInst* branch = branches[i];
+        IRBuilder<> builder(branch);
+        Value* index = builder.CreateSelect(branch->getCondition(), builder.getInt64(1 + 2 * i),
+                                            builder.getInt64(2 + 2 * i), "edge");
+        incrementCounter(builder, counters, index);
+    }
+}
+
+/* Attach the edge counts of the profile to the conditional branches of the
+   function as branch weights, which drive block placement, and mark methods
+   that were never entered cold and the hottest ones for inlining (-fprofile-use). */
+static void applyProfile(Function* function) {
+    StringMap<vector<uint64_t> >::iterator it = profileCounts.find(function->getName());
+    if (it == profileCounts.end()) {
+        return;
+    }
+
+    vector<uint64_t>& counts = it->second;
+    vector<BranchInst*> branches;
+    collectBranches(function, branches);
+    if (counts.size() != 1 + 2 * branches.size()) {
+        return;
+    }
+
+    MDBuilder mdBuilder(function->getContext());
+    for (size_t i = 0; i < branches.size(); i++) {
+        uint64_t trueCount = counts[1 + 2 * i];
+        uint64_t falseCount = counts[2 + 2 * i];
+        uint64_t scale = max(trueCount, falseCount) / MAX_BRANCH_WEIGHT + 1;
+
+        // Edges never taken keep a weight of one, they were not proven impossible.
+        MDNode* weights = mdBuilder.createBranchWeights(trueCount / scale + 1, falseCount / scale + 1);
+        branches[i]->setMetadata(LLVMContext::MD_prof, weights);
+    }
+
+    uint64_t entryCount = counts[0];
+    if (entryCount == 0) {
+        function->addFnAttr(Attribute::Cold);
+    } else if (entryCount >= maxEntryCount / HOT_METHOD_DIVISOR) {
+        function->addFnAttr(Attribute::InlineHint);
+    }
+}
+
+/* Instrument or weigh the generated (not yet optimized) function for the
+   -fprofile-generate or -fprofile-use mode. */
+void profileFunction(CompileContext& context, Function* function) {
+    if (getProfileMode() == PROFILE_GENERATE) {
+        instrumentFunction(context, function);
+    } else if (getProfileMode() == PROFILE_USE) {
+        applyProfile(function);
+    }
+}
+
+/* Return an i8* to a private copy of the string in the module. */
+static Constant* createStringConstant(Module* module, StringRef str) {
+    Constant* data = ConstantDataArray::getString(module->getContext(), str);
+    GlobalVariable* global = new GlobalVariable(*module, data->getType(), true, GlobalValue::PrivateLinkage, data,
+                                                PROFILE_STRING);
+    return ConstantExpr::getBitCast(global, Type::getInt8PtrTy(module->getContext()));
+}
+
+/* Build the table of the counter arrays of all methods and hand it to the
+   runtime when main starts, which writes the counts at exit. */
+static void registerCounters(Module* module) {
+    Function* main = module->getFunction(VALUE_MAIN);
+    if (main == NULL || main->isDeclaration()) {
+        return;
+    }
+
+    LLVMContext& llvmContext = module->getContext();
+    Type* nameType = Type::getInt8PtrTy(llvmContext);
+    Type* sizeType = Type::getInt32Ty(llvmContext);
+    Type* countersType = Type::getInt64PtrTy(llvmContext);
+    StructType* entryType = StructType::get(nameType, sizeType, countersType, NULL);
+
+    vector<Constant*> entries;
+    for (Module::iterator it = module->begin(); it != module->end(); it++) {
+        string countersName = (Twine(PROFILE_COUNTERS_PREFIX) + it->getName()).str();
+        GlobalVariable* counters = module->getGlobalVariable(countersName, true);
+        if (counters == NULL) {
+            continue;
+        }
+
+        ArrayType* arrayType = cast<ArrayType>(counters->getType()->getElementType());
+        Constant* fields[] = {
+            createStringConstant(module, it->getName()),
+            ConstantInt::get(sizeType, arrayType->getNumElements()),
+            ConstantExpr::getBitCast(counters, countersType)
+        };
+        entries.push_back(ConstantStruct::get(entryType, fields));
+    }
+
+    ArrayType* tableType = ArrayType::get(entryType, entries.size());
+    GlobalVariable* table = new GlobalVariable(*module, tableType, true, GlobalValue::InternalLinkage,
+                                               ConstantArray::get(tableType, entries), PROFILE_TABLE);
+
+    Type* paramTypes[] = { PointerType::getUnqual(entryType), sizeType, nameType };
+    FunctionType* startType = FunctionType::get(Type::getVoidTy(llvmContext), paramTypes, false);
+    Constant* start = module->getOrInsertFunction(PROFILE_START_FUNCTION, startType);
+
+    BasicBlock& entryBlock = main->getEntryBlock();
+    IRBuilder<> builder(&entryBlock, entryBlock.getFirstInsertionPt());
+    builder.CreateCall3(start, ConstantExpr::getBitCast(table, paramTypes[0]), builder.getInt32(entries.size()),
+                        createStringConstant(module, getProfileFile()));
+}
+
+/* Return true if the first method was entered more often than the second. */
+static bool isHotter(const pair<uint64_t, Function*>& first, const pair<uint64_t, Function*>& second) {
+    return first.first > second.first;
+}
+
+/* Place the hottest methods first and the cold ones last, so that the code that
+   runs together is laid out together. */
+static void orderFunctions(Module* module) {
+    vector<pair<uint64_t, Function*> > order;
+    for (Module::iterator it = module->begin(); it != module->end(); it++) {
+        if (it->isDeclaration()) {
+            continue;
+        }
+
+        StringMap<vector<uint64_t> >::iterator counts = profileCounts.find(it->getName());
+        uint64_t entryCount = (counts != profileCounts.end() ? counts->second[0] : 0);
+        order.push_back(make_pair(entryCount, (Function*) it));
+    }
+
+    stable_sort(order.begin(), order.end(), isHotter);
+    for (size_t i = 0; i < order.size(); i++) {
+        Function* function = order[i].second;
+        module->getFunctionList().remove(function);
+        module->getFunctionList().push_back(function);
+    }
+}
+
+/* Finish the profile guided mode once all methods are generated, before the
+   module passes run: register the counters with the runtime (-fprofile-generate),
+   or order the methods by their entry counts (-fprofile-use). */
+void finishProfile(CompileContext& context) {
+    if (getProfileMode() == PROFILE_GENERATE) {
+        registerCounters(context.module);
+    } else if (getProfileMode() == PROFILE_USE) {
+        orderFunctions(context.module);
+    }
+}
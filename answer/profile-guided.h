@@ -0,0 +1,13 @@
+#ifndef PROFILE_GUIDED_H
+#define PROFILE_GUIDED_H
+
+#include "llvm/IR/Function.h"
+#include "compile-context.h"
+
+using namespace llvm;
+
+void initializeProfile();
+void profileFunction(CompileContext& context, Function* function);
+void finishProfile(CompileContext& context);
+
+#endif
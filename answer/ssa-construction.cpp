@@ -0,0 +1,192 @@
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/ValueHandle.h"
+#include "compile-context.h"
+#include "compile-options.h"
+#include "ssa-construction.h"
+#include <iterator>
+#include <utility>
+#include <vector>
+
+using namespace llvm;
+using namespace std;
+
+/* Locals are kept in SSA values while the code is generated, following Braun et
+   al., "Simple and Efficient Construction of Static Single Assignment Form". The
+   current value of a variable is recorded per block; reading it in a block
+   without a definition looks through the predecessors, placing a phi where
+   several of them meet. A block is sealed once all of its predecessors are
+   known. Reads in unsealed blocks (loop headers, joins) get an operandless phi,
+   completed when the block is sealed. Trivial phis, merging a single value, are
+   removed as soon as they are complete, so the result is close to minimal SSA. */
+
+static Value* readVariableRecursive(CompileContext& context, AllocaInst* variable, BasicBlock* block);
+
+/* Create a variable for a local (or parameter) with the provided type and id. In
+   direct SSA mode the alloca is never inserted in the function, it only
+   identifies the variable (in the symbol table and the definition map) and is
+   deleted with releaseLocalVariables. Otherwise the alloca is placed at the start
+   of the entry block, where mem2reg can promote it wherever it was declared. */
+AllocaInst* createLocalVariable(CompileContext& context, Type* type, char* id) {
+    if (isDirectSsaEnabled()) {
+        AllocaInst* variable = new AllocaInst(type, id);
+        context.localVariables.push_back(variable);
+        return variable;
+    }
+
+    BasicBlock& entryBlock = context.builder.GetInsertBlock()->getParent()->getEntryBlock();
+    IRBuilder<> entryBuilder(&entryBlock, entryBlock.begin());
+    return entryBuilder.CreateAlloca(type, 0, id);
+}
+
+/* Return true if the value is a local kept in SSA values (see createLocalVariable). */
+bool isLocalVariable(Value* value) {
+    AllocaInst* variable = dyn_cast<AllocaInst>(value);
+    return (variable != NULL && variable->getParent() == NULL);
+}
+
+/* Record the value as the current value of the variable at the end of the block. */
+void writeVariable(CompileContext& context, AllocaInst* variable, BasicBlock* block, Value* value) {
+    context.currentDefs[make_pair(variable, block)] = value;
+}
+
+/* Return the value of the variable at the end of the block. */
+Value* readVariable(CompileContext& context, AllocaInst* variable, BasicBlock* block) {
+    DenseMap<pair<AllocaInst*, BasicBlock*>, WeakVH>::iterator it = context.currentDefs.find(make_pair(variable, block));
+    if (it != context.currentDefs.end() && it->second != NULL) {
+        return it->second;
+    }
+
+    return readVariableRecursive(context, variable, block);
+}
+
+/* Create an operandless phi for the variable at the start of the block. */
+static PHINode* createPhi(AllocaInst* variable, BasicBlock* block) {
+    Type* type = variable->getAllocatedType();
+    if (block->empty()) {
+        return PHINode::Create(type, 0, variable->getName(), block);
+    }
+
+    return PHINode::Create(type, 0, variable->getName(), &block->front());
+}
+
+/* Return true if the phi has an incoming value for every predecessor, phis
+   still being completed must not be removed as trivial. */
+static bool isCompletePhi(PHINode* phi) {
+    BasicBlock* block = phi->getParent();
+    return (phi->getNumIncomingValues() == (unsigned) distance(pred_begin(block), pred_end(block)));
+}
+
+/* Remove the phi if it merges a single value (besides itself), replacing it by
+   that value, and return whatever now stands for it. Phis using the removed phi
+   may have become trivial in turn. */
+static Value* tryRemoveTrivialPhi(PHINode* phi) {
+    Value* same = NULL;
+    for (unsigned i = 0; i < phi->getNumIncomingValues(); i++) {
+        Value* incoming = phi->getIncomingValue(i);
+        if (incoming == same || incoming == phi) {
+            continue;
+        }
+        if (same != NULL) {
+            return phi;
+        }
+        same = incoming;
+    }
+
+    // Only reachable through itself, or not at all.
+    if (same == NULL) {
+        same = UndefValue::get(phi->getType());
+    }
+
+    SmallVector<WeakVH, 8> phiUsers;
+    for (Value::use_iterator it = phi->use_begin(); it != phi->use_end(); it++) {
+        if (*it != phi && isa<PHINode>(*it)) {
+            phiUsers.push_back(*it);
+        }
+    }
+
+    // The handles in the definition map follow the replacement.
+    WeakVH result(same);
+    phi->replaceAllUsesWith(same);
+    phi->eraseFromParent();
+
+    for (size_t i = 0; i < phiUsers.size(); i++) {
+        PHINode* user = dyn_cast_or_null<PHINode>(phiUsers[i]);
+        if (user != NULL && isCompletePhi(user)) {
+            tryRemoveTrivialPhi(user);
+        }
+    }
+
+    return result;
+}
+
+/* Add the value of the variable in every predecessor to its phi. */
+static Value* addPhiOperands(CompileContext& context, AllocaInst* variable, PHINode* phi) {
+    BasicBlock* block = phi->getParent();
+    for (pred_iterator it = pred_begin(block); it != pred_end(block); it++) {
+        phi->addIncoming(readVariable(context, variable, *it), *it);
+    }
+
+    return tryRemoveTrivialPhi(phi);
+}
+
+/* Find the value of a variable not defined in the block through its predecessors. */
+static Value* readVariableRecursive(CompileContext& context, AllocaInst* variable, BasicBlock* block) {
+    Value* value;
+    if (context.sealedBlocks.count(block) == 0) {
+        // More predecessors may follow, the phi is completed by sealBlock.
+        PHINode* phi = createPhi(variable, block);
+        context.incompletePhis[block].push_back(make_pair(variable, phi));
+        value = phi;
+    } else if (BasicBlock* predecessor = block->getSinglePredecessor()) {
+        value = readVariable(context, variable, predecessor);
+    } else if (pred_begin(block) == pred_end(block)) {
+        // Read before any assignment, in the entry block or unreachable code.
+        value = UndefValue::get(variable->getAllocatedType());
+    } else {
+        // Define the phi before reading the predecessors, which may loop back here.
+        PHINode* phi = createPhi(variable, block);
+        writeVariable(context, variable, block, phi);
+        value = addPhiOperands(context, variable, phi);
+    }
+
+    writeVariable(context, variable, block, value);
+    return value;
+}
+
+/* Mark the block as having all of its predecessors, completing the phis placed
+   in it while it had not. Must be called for every block a local may be read in,
+   once the branches to it have been generated. */
+void sealBlock(CompileContext& context, BasicBlock* block) {
+    if (!isDirectSsaEnabled()) {
+        return;
+    }
+
+    // Sealed first, so that reads of other variables while completing these
+    // phis place complete phis right away.
+    context.sealedBlocks.insert(block);
+    DenseMap<BasicBlock*, IncompletePhiList>::iterator it = context.incompletePhis.find(block);
+    if (it == context.incompletePhis.end()) {
+        return;
+    }
+
+    IncompletePhiList phis;
+    phis.swap(it->second);
+    context.incompletePhis.erase(it);
+    for (size_t i = 0; i < phis.size(); i++) {
+        addPhiOperands(context, phis[i].first, phis[i].second);
+    }
+}
+
+/* Forget the SSA construction state of the method and delete its variables. */
+void releaseLocalVariables(CompileContext& context) {
+    context.currentDefs.clear();
+    context.sealedBlocks.clear();
+    context.incompletePhis.clear();
+    for (size_t i = 0; i < context.localVariables.size(); i++) {
+        delete context.localVariables[i];
+    }
+    context.localVariables.clear();
+}
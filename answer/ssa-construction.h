@@ -0,0 +1,19 @@
+#ifndef SSA_CONSTRUCTION_H
+#define SSA_CONSTRUCTION_H
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Value.h"
+
+using namespace llvm;
+
+struct CompileContext;
+
+AllocaInst* createLocalVariable(CompileContext& context, Type* type, char* id);
+bool isLocalVariable(Value* value);
+void writeVariable(CompileContext& context, AllocaInst* variable, BasicBlock* block, Value* value);
+Value* readVariable(CompileContext& context, AllocaInst* variable, BasicBlock* block);
+void sealBlock(CompileContext& context, BasicBlock* block);
+void releaseLocalVariables(CompileContext& context);
+
+#endif
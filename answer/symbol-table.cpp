@@ -1,7 +1,8 @@
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Value.h"
+#include "compile-context.h"
+#include "symbol-table.h"
 #include <cstdio>
-#include <map>
-#include <string>
 #include <stdlib.h>
 #include <vector>
 
@@ -11,92 +12,94 @@ using namespace std;
 static const int INDEX_EXTERN = 0;
 static const int INDEX_CLASS = 1;
 
-typedef map<string, Value*> SymbolTable;
-typedef vector<SymbolTable*> SymbolTableVector;
-
-static SymbolTableVector symbolTableStack;
-static SymbolTableVector symbolTablePool;
-
-void pushSymbolTable() {
-    /* symbolTableStack.push_back(new SymbolTable); */
-    SymbolTable* test = new SymbolTable;
-    symbolTableStack.push_back(test);
-    symbolTablePool.push_back(test);
+/* Return the unique copy of the provided identifier. Identifiers passed to the
+   symbol table must have been interned, as they are compared by address. */
+char* internIdentifier(CompileContext& context, const char* id) {
+    StringMapEntry<char>& entry = context.identifierTable.GetOrCreateValue(id);
+    return (char*) entry.getKeyData();
 }
 
-void popSymbolTable() {
-    symbolTableStack.pop_back();
+void pushSymbolTable(CompileContext& context) {
+    // The identifier lists of popped scopes are reused rather than reallocated.
+    if (context.scopeDepth == (int) context.scopeStack.size()) {
+        context.scopeStack.push_back(vector<const char*>());
+    }
+    context.scopeDepth++;
 }
 
-void insertSymbol(char* id, Value* value) {
-    if (symbolTableStack.empty()) {
-        fprintf(stderr, "symbolTableStack is empty.\n");
-        exit(EXIT_FAILURE);
+void popSymbolTable(CompileContext& context) {
+    vector<const char*>& scope = context.scopeStack[context.scopeDepth - 1];
+    for (vector<const char*>::iterator idIt = scope.begin(); idIt != scope.end(); idIt++) {
+        SymbolTable::iterator chainIt = context.symbolTable.find(*idIt);
+        chainIt->second.pop_back();
     }
 
-    SymbolTable* symbolTable = symbolTableStack.back();
-    string* symbolId = new string(id);  
-   
-    (*symbolTable)[*symbolId] = value;
+    scope.clear();
+    context.scopeDepth--;
 }
 
-void insertExternSymbol(char* id, Value* value) {
-    if (symbolTableStack.empty()) {
+/* Bind the provided value to the identifier in the scope at the provided depth,
+   replacing any value already bound to it by that scope. */
+static void bindSymbol(CompileContext& context, int depth, const char* id, Value* value) {
+    if (context.scopeDepth == 0) {
         fprintf(stderr, "symbolTableStack is empty.\n");
         exit(EXIT_FAILURE);
     }
 
-    SymbolTable* symbolTable = symbolTableStack.at(INDEX_EXTERN);
-    string* symbolId = new string(id);  
-   
-    (*symbolTable)[*symbolId] = value;
-}
+    ShadowChain& chain = context.symbolTable[id];
 
-void insertFunctionSymbol(char* id, Function* function) {
-    if (symbolTableStack.empty()) {
-        fprintf(stderr, "symbolTableStack is empty.\n");
-        exit(EXIT_FAILURE);
+    // Find the first binding made by this scope or one nested within it.
+    ShadowChain::iterator entryIt = chain.end();
+    while (entryIt != chain.begin() && (entryIt - 1)->depth >= depth) {
+        entryIt--;
     }
 
-    SymbolTable* symbolTable = symbolTableStack.at(INDEX_CLASS);
-    string* symbolId = new string(id);  
-   
-    (*symbolTable)[*symbolId] = (Value*) function;
+    if (entryIt != chain.end() && entryIt->depth == depth) {
+        entryIt->value = value;
+    } else {
+        SymbolEntry entry = { depth, value };
+        chain.insert(entryIt, entry);
+        context.scopeStack[depth].push_back(id);
+    }
 }
 
-Value* getValue(char* id) {
-    if (symbolTableStack.empty()) {
+void insertSymbol(CompileContext& context, char* id, Value* value) {
+    bindSymbol(context, context.scopeDepth - 1, id, value);
+}
+
+void insertExternSymbol(CompileContext& context, char* id, Value* value) {
+    bindSymbol(context, INDEX_EXTERN, id, value);
+}
+
+void insertFunctionSymbol(CompileContext& context, char* id, Function* function) {
+    bindSymbol(context, INDEX_CLASS, id, (Value*) function);
+}
+
+Value* getValue(CompileContext& context, char* id) {
+    if (context.scopeDepth == 0) {
         fprintf(stderr, "symbolTableStack is empty.\n");
         exit(EXIT_FAILURE);
     }
 
-    string symbolId(id);
-    for (SymbolTableVector::reverse_iterator tableIt = symbolTableStack.rbegin(); tableIt != symbolTableStack.rend(); tableIt++) {
-        SymbolTable* table = *(tableIt);
-        
-        SymbolTable::iterator resultIt = table->find(symbolId);
-        // If not equal to the end, then the symbol table contains the symbol.
-        if (resultIt != table->end()) {
-            return (resultIt->second);
-        }
+    // The innermost binding shadows all others.
+    SymbolTable::iterator chainIt = context.symbolTable.find(id);
+    if (chainIt == context.symbolTable.end() || chainIt->second.empty()) {
+        return NULL;
     }
 
-    return NULL;
+    return chainIt->second.back().value;
 }
 
-void debug() {
+void debug(CompileContext& context) {
     printf("====================================================================================\n");
     printf("DEBUG\n");
     
-    int i = 1;
-    for (SymbolTableVector::iterator tableIt = symbolTablePool.begin(); tableIt != symbolTablePool.end(); tableIt++) {
-        printf("Symbol Table #%d\n", i);
+    for (int i = 0; i < context.scopeDepth; i++) {
+        printf("Symbol Table #%d\n", i + 1);
 
-        SymbolTable* table = *(tableIt);
-        for (SymbolTable::iterator symbolIt = table->begin(); symbolIt != table->end(); symbolIt++) {
-            printf("\tKey (ID) = %s\n", symbolIt->first.c_str());
+        vector<const char*>& scope = context.scopeStack[i];
+        for (vector<const char*>::iterator idIt = scope.begin(); idIt != scope.end(); idIt++) {
+            printf("\tKey (ID) = %s\n", *idIt);
         }
-
-        i++;
     }
 }
@@ -1,6 +1,10 @@
 #ifndef DECAF_SYMTBL_H
 #define DECAF_SYMTBL_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/IR/Function.h"
 #include "llvm/IR/Value.h"
 #include <cstdio>
 #include <map>
@@ -11,12 +15,28 @@
 using namespace llvm;
 using namespace std;
 
-void pushSymbolTable(); 
-void popSymbolTable();
-void insertSymbol(char* id, Value* value);
-void insertExternSymbol(char* id, Value* value);
-void insertFunctionSymbol(char* id, Function* function);
-Value* getValue(char* id);
-void debug();
+struct CompileContext;
+
+// SymbolEntry - A value bound to an identifier by the scope at the provided depth.
+struct SymbolEntry {
+    int depth;
+    Value* value;
+};
+
+// All bindings of a single identifier, ordered from outermost to innermost scope.
+typedef SmallVector<SymbolEntry, 2> ShadowChain;
+// Keyed by interned identifier, so lookups hash and compare pointers only.
+typedef DenseMap<const char*, ShadowChain> SymbolTable;
+// Identifiers bound by each scope, used to unwind the scope when it is popped.
+typedef vector<vector<const char*> > ScopeVector;
+
+char* internIdentifier(CompileContext& context, const char* id);
+void pushSymbolTable(CompileContext& context);
+void popSymbolTable(CompileContext& context);
+void insertSymbol(CompileContext& context, char* id, Value* value);
+void insertExternSymbol(CompileContext& context, char* id, Value* value);
+void insertFunctionSymbol(CompileContext& context, char* id, Function* function);
+Value* getValue(CompileContext& context, char* id);
+void debug(CompileContext& context);
 
 #endif
@@ -1,42 +1,28 @@
 #ifndef VALUE_CONSTANTS_H
 #define VALUE_CONSTANTS_H
 
+#include "compile-error.h"
 #include <cstdio>
 #include <cstdlib>
 
-void throwError(const char* errorMsg, int errorCode) {
-    fprintf(stderr, errorMsg);
-    exit(errorCode);
+static bool recoverableErrors = false;
+
+/* Make throwError raise a CompileError instead of exiting the program. */
+void setRecoverableErrors(bool recoverable) {
+    recoverableErrors = recoverable;
 }
 
-// Binary Operators
-const char* VALUE_OR = "||";
-const char* VALUE_AND = "&&";
-const char* VALUE_EQ = "==";
-const char* VALUE_NEQ = "!=";
-const char* VALUE_LT = "<";
-const char* VALUE_LEQ = "<=";
-const char* VALUE_GT = ">";
-const char* VALUE_GEQ = ">=";
-const char* VALUE_PLUS = "+";
-const char* VALUE_MINUS = "-";
-const char* VALUE_MULT = "*";
-const char* VALUE_DIV = "/";
-const char* VALUE_MOD = "%";
-const char* VALUE_RIGHTSHIFT = "<<";
-const char* VALUE_LEFTSHIFT = ">>";
+void throwError(const char* errorMsg, int errorCode) {
+    if (recoverableErrors) {
+        throw CompileError(errorMsg, errorCode);
+    }
 
-// Unary Operators
-const char* VALUE_NOT = "!";
-const char* VALUE_NEGATE = "-";
+    fprintf(stderr, "%s", errorMsg);
+    exit(errorCode);
+}
 
 // Constant Values
-const char* VALUE_TRUE = "true";
-const char* VALUE_FALSE = "false";
-const char* VALUE_VOIDTYPE = "void";
-const char* VALUE_INTTYPE = "int";
-const char* VALUE_BOOLTYPE = "bool";
-const char* VALUE_STRINGTYPE = "string";
+const char* VALUE_MAIN = "main";
 int VALUE_SCALAR = -1;
 
 // Error Messages
@@ -52,6 +38,13 @@ const char* ERROR_VARIABLE_UNDECLARED = "Variable has not been declared.\n";
 const char* ERROR_FUNCTION_IS_VOID = "Function has a void return type and therefore has no return value.\n";
 const char* ERROR_INDEX_TOO_LOW = "Invalid array size, must be at least 1.\n";
 const char* ERROR_NO_MAIN = "There exists no main function.\n";
+const char* ERROR_UNKNOWN_OPTION = "Unknown command line option.\n";
+const char* ERROR_INVALID_OPTION_VALUE = "Invalid command line option value, expected a non-negative integer.\n";
+const char* ERROR_PARSE_FAILED = "Could not parse the program.\n";
+const char* ERROR_INVALID_ESCAPE = "Invalid escaped character.\n";
+const char* ERROR_BAD_REQUEST = "Malformed compile request.\n";
+const char* ERROR_WORKER_FAILED = "A code generation worker terminated abnormally.\n";
+const char* ERROR_PROFILE_UNREADABLE = "Could not read the profile given to -fprofile-use.\n";
 
 // Exit Values
 int EXIT_NO_ERROR = 0;
@@ -3,36 +3,47 @@
 
 void throwError(const char* errorMsg, int errorCode);
 
-// Binary Operators
-extern const char* VALUE_OR;
-extern const char* VALUE_AND;
-extern const char* VALUE_EQ;
-extern const char* VALUE_NEQ;
-extern const char* VALUE_LT;
-extern const char* VALUE_LEQ;
-extern const char* VALUE_GT;
-extern const char* VALUE_GEQ;
-extern const char* VALUE_PLUS;
-extern const char* VALUE_MINUS;
-extern const char* VALUE_MULT;
-extern const char* VALUE_DIV;
-extern const char* VALUE_MOD;
-extern const char* VALUE_RIGHTSHIFT;
-extern const char* VALUE_LEFTSHIFT;
-
-// Unary Operators
-extern const char* VALUE_NOT;
-extern const char* VALUE_NEGATE;
+// DecafBinaryOp - Binary operators, resolved by the parser.
+enum DecafBinaryOp {
+    OP_OR,
+    OP_AND,
+    OP_EQ,
+    OP_NEQ,
+    OP_LT,
+    OP_LEQ,
+    OP_GT,
+    OP_GEQ,
+    OP_PLUS,
+    OP_MINUS,
+    OP_MULT,
+    OP_DIV,
+    OP_MOD,
+    OP_RIGHTSHIFT,
+    OP_LEFTSHIFT
+};
+
+// DecafUnaryOp - Unary operators, resolved by the parser.
+enum DecafUnaryOp {
+    OP_NOT,
+    OP_NEGATE
+};
+
+// DecafType - Decaf data types, see getLLVMType for the corresponding LLVM types.
+enum DecafType {
+    TYPE_VOID,
+    TYPE_INT,
+    TYPE_BOOL,
+    TYPE_STRING,
+    TYPE_COUNT
+};
 
 // Constant Values
-extern const char* VALUE_TRUE;
-extern const char* VALUE_FALSE;
-extern const char* VALUE_VOIDTYPE;
-extern const char* VALUE_INTTYPE;
-extern const char* VALUE_BOOLTYPE;
-extern const char* VALUE_STRINGTYPE;
+extern const char* VALUE_MAIN;
 extern const int VALUE_SCALAR;
 
+// Size of the buffers the scanner and parser format their error messages in.
+const int ERROR_MESSAGE_LENGTH = 256;
+
 // Error Messages
 extern const char* ERROR_BOOL_TO_INT;
 extern const char* ERROR_INT_TO_BOOL;
@@ -47,6 +58,13 @@ extern const char* ERROR_VARIABLE_UNDECLARED;
 extern const char* ERROR_FUNCTION_IS_VOID;
 extern const char* ERROR_INDEX_TOO_LOW;
 extern const char* ERROR_NO_MAIN;
+extern const char* ERROR_UNKNOWN_OPTION;
+extern const char* ERROR_INVALID_OPTION_VALUE;
+extern const char* ERROR_PARSE_FAILED;
+extern const char* ERROR_INVALID_ESCAPE;
+extern const char* ERROR_BAD_REQUEST;
+extern const char* ERROR_WORKER_FAILED;
+extern const char* ERROR_PROFILE_UNREADABLE;
 
 
 // Exit Values
@@ -0,0 +1,182 @@
+#!/usr/bin/env python
+
+"""
+usage: %s [options]
+
+Measure the end to end compile throughput of decaf-codegen on synthetic
+programs (see decaf-gen.py) of increasing size. Every size is compiled with
+-time-report=json, so that the per phase time and memory growth reported by
+the compiler can be shown next to the wall clock time.
+
+Options
+-c CODEGEN     path to the compiler codegen executable (default %s)
+-O LEVEL       optimization level passed to CODEGEN (default %d)
+-f FLAGS       extra flags passed to CODEGEN, e.g. "-jobs=4 -fbounds-check"
+-k SCALES      comma separated list of scale factors (default %s)
+-d DIMENSION   what a scale factor multiplies: methods, statements, depth,
+               locals, expr-depth or arrays (default methods). The generated
+               code grows exponentially with depth and expr-depth, so scale
+               factor K adds K - 1 to these instead of multiplying them, up
+               to a depth of %d and an expression depth of %d (or the base size)
+-n REPEAT      compile each program REPEAT times and keep the fastest (default %d)
+-j FILE        also write all results to FILE as JSON
+
+Program options, the base size that is scaled (see decaf-gen.py)
+-m METHODS, -s STATEMENTS, -e DEPTH, -l LOCALS, -x EXPR-DEPTH, -a ARRAYS, -r SEED
+"""
+
+import json
+import os
+import os.path
+import shlex
+import subprocess
+import sys
+import tempfile
+import time
+
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+
+def load_decaf_gen():
+    """Import decaf-gen.py, whose name is not a valid module name."""
+    path = os.path.join(bench_dir, "decaf-gen.py")
+    try:
+        import importlib.util
+        spec = importlib.util.spec_from_file_location("decaf_gen", path)
+        module = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(module)
+        return module
+    except ImportError:
+        import imp
+        return imp.load_source("decaf_gen", path)
+
+decaf_gen = load_decaf_gen()
+
+default_codegen = os.path.join(bench_dir, "..", "answer", "decaf-codegen")
+default_opt_level = 1
+default_scales = "1,2,4,8,16"
+default_repeat = 3
+dimensions = ["methods", "statements", "depth", "locals", "expr-depth", "arrays"]
+depth_limits = { "depth": 4, "expr-depth": 12 }
+phases = ["lex", "parse", "declarations", "bodies", "function passes", "module passes", "output"]
+
+def compile_once(codegen, flags, source_path):
+    """Compile the source, returning the wall time and the JSON time report."""
+    cmd = [codegen, "-time-report=json", "-emit-bc", "-o", os.devnull] + flags
+    with open(source_path, "r") as istream:
+        start = time.time()
+        process = subprocess.Popen(cmd, stdin=istream, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out, err = process.communicate()
+        wall = time.time() - start
+    if process.returncode != 0:
+        sys.stderr.write(err.decode("utf-8", "replace"))
+        raise RuntimeError("%s failed with status %d on %s" % (" ".join(cmd), process.returncode, source_path))
+
+    report = None
+    for line in err.decode("utf-8", "replace").splitlines():
+        if line.startswith("{"):
+            report = json.loads(line)
+    if report is None:
+        raise RuntimeError("%s printed no time report, was it built with -time-report support?" % codegen)
+    return wall, report
+
+def measure(codegen, flags, source, repeat):
+    """Compile the source REPEAT times, returning the result of the fastest run."""
+    handle, source_path = tempfile.mkstemp(prefix="decaf-bench.", suffix=".decaf")
+    try:
+        with os.fdopen(handle, "w") as ostream:
+            ostream.write(source)
+        runs = [compile_once(codegen, flags, source_path) for i in range(repeat)]
+    finally:
+        os.remove(source_path)
+
+    wall, report = min(runs, key=lambda run: run[0])
+    lines = source.count("\n")
+    return {
+        "lines": lines,
+        "wall": wall,
+        "lines_per_sec": lines / wall,
+        "instructions_per_sec": report["instructions_before"] / wall,
+        "report": report,
+    }
+
+def print_results(results):
+    header = "%6s %8s %9s %12s %12s %10s" % ("scale", "lines", "wall (s)", "lines/s", "IR insts/s", "peak KB")
+    sys.stdout.write(header + "\n")
+    for result in results:
+        sys.stdout.write("%6d %8d %9.4f %12.0f %12.0f %10d\n" % (result["scale"], result["lines"], result["wall"],
+                         result["lines_per_sec"], result["instructions_per_sec"], result["report"]["peak_rss_kb"]))
+
+    sys.stdout.write("\nPer phase wall time in seconds (RSS growth in KB)\n")
+    sys.stdout.write("%6s" % "scale" + "".join(" %20s" % phase for phase in phases) + "\n")
+    for result in results:
+        cells = []
+        for phase in phases:
+            stats = result["report"]["phases"][phase]
+            cells.append(" %20s" % ("%.4f (%d)" % (stats["wall"], stats["rss_growth_kb"])))
+        sys.stdout.write("%6d" % result["scale"] + "".join(cells) + "\n")
+
+if __name__ == '__main__':
+    import getopt
+
+    codegen = default_codegen
+    opt_level = default_opt_level
+    flags = []
+    scales = default_scales
+    dimension = "methods"
+    repeat = default_repeat
+    json_file = None
+    size = { "methods": decaf_gen.default_methods, "statements": decaf_gen.default_statements,
+             "depth": decaf_gen.default_depth, "locals": decaf_gen.default_locals,
+             "expr-depth": decaf_gen.default_expr_depth, "arrays": decaf_gen.default_arrays }
+    size_options = { "-m": "methods", "-s": "statements", "-e": "depth", "-l": "locals", "-x": "expr-depth",
+                     "-a": "arrays" }
+    seed = decaf_gen.default_seed
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "c:O:f:k:d:n:j:m:s:e:l:x:a:r:")
+        for opt, value in opts:
+            if opt == "-c":
+                codegen = value
+            elif opt == "-O":
+                opt_level = int(value)
+            elif opt == "-f":
+                flags = shlex.split(value)
+            elif opt == "-k":
+                scales = value
+            elif opt == "-d":
+                dimension = value
+            elif opt == "-n":
+                repeat = int(value)
+            elif opt == "-j":
+                json_file = value
+            elif opt == "-r":
+                seed = int(value)
+            else:
+                size[size_options[opt]] = int(value)
+        scales = [int(scale) for scale in scales.split(",")]
+        if args or dimension not in dimensions or repeat < 1:
+            raise getopt.GetoptError("Invalid arguments.")
+    except (getopt.GetoptError, ValueError):
+        sys.stderr.write(__doc__ % (sys.argv[0], default_codegen, default_opt_level, default_scales,
+                                    depth_limits["depth"], depth_limits["expr-depth"], default_repeat))
+        sys.exit(2)
+
+    results = []
+    for scale in scales:
+        scaled = dict(size)
+        if dimension in depth_limits:
+            scaled[dimension] = min(size[dimension] + scale - 1, max(size[dimension], depth_limits[dimension]))
+        else:
+            scaled[dimension] = size[dimension] * scale
+        source = decaf_gen.generate(scaled["methods"], scaled["statements"], scaled["depth"], scaled["locals"],
+                                    scaled["expr-depth"], scaled["arrays"], seed)
+        result = measure(codegen, ["-O%d" % opt_level] + flags, source, repeat)
+        result["scale"] = scale
+        result["size"] = scaled
+        results.append(result)
+
+    print_results(results)
+    if json_file is not None:
+        with open(json_file, "w") as ostream:
+            json.dump({ "dimension": dimension, "opt_level": opt_level, "flags": flags, "results": results }, ostream,
+                      indent=2, sort_keys=True)
@@ -0,0 +1,200 @@
+#!/usr/bin/env python
+
+"""
+usage: %s [options] [OUTPUT-FILE]
+
+Generate a synthetic Decaf class for compile throughput measurements. The
+program is written to OUTPUT-FILE, or to standard output if none is given.
+
+Options
+-m METHODS     number of methods besides main (default %d)
+-s STATEMENTS  statements per block (default %d)
+-n DEPTH       nesting depth of if/while/for blocks (default %d)
+-l LOCALS      local variables declared per scope (default %d)
+-x DEPTH       depth of generated expression trees (default %d)
+-a ARRAYS      number of global arrays (default %d)
+-r SEED        random seed, the same options and seed give the same program (default %d)
+"""
+
+import random
+import sys
+
+default_methods = 20
+default_statements = 8
+default_depth = 2
+default_locals = 4
+default_expr_depth = 3
+default_arrays = 4
+default_seed = 1
+array_size = 100
+loop_count = 10
+
+class Generator(object):
+    def __init__(self, methods, statements, depth, locals_per_scope, expr_depth, arrays, seed):
+        self.methods = methods
+        self.statements = statements
+        self.depth = depth
+        self.locals_per_scope = locals_per_scope
+        self.expr_depth = expr_depth
+        self.arrays = arrays
+        self.random = random.Random(seed)
+        self.lines = []
+        self.scopes = []
+        self.next_local = 0
+
+    def emit(self, indent, text):
+        self.lines.append("    " * indent + text)
+
+    def visible_locals(self):
+        return [name for scope in self.scopes for name in scope]
+
+    def int_expr(self, depth):
+        """Return an integer expression tree of at most the provided depth."""
+        leaves = self.visible_locals()
+        if depth <= 0 or self.random.random() < 0.2:
+            choice = self.random.random()
+            if leaves and choice < 0.6:
+                return self.random.choice(leaves)
+            if self.arrays > 0 and choice < 0.8:
+                return "g%d[%d]" % (self.random.randrange(self.arrays), self.random.randrange(array_size))
+            return str(self.random.randrange(1, 1000))
+        op = self.random.choice(["+", "-", "*", "/", "%"])
+        left = self.int_expr(depth - 1)
+        if op in ["/", "%"]:
+            # Constant divisors, so that generated programs never divide by zero.
+            right = str(self.random.randrange(1, 10))
+        else:
+            right = self.int_expr(depth - 1)
+        return "(%s %s %s)" % (left, op, right)
+
+    def bool_expr(self, depth):
+        """Return a boolean expression comparing integer expressions."""
+        op = self.random.choice(["<", "<=", ">", ">=", "==", "!="])
+        cond = "%s %s %s" % (self.int_expr(depth - 1), op, self.int_expr(depth - 1))
+        if depth > 1 and self.random.random() < 0.3:
+            cond = "(%s) %s (%s)" % (cond, self.random.choice(["&&", "||"]), self.bool_expr(depth - 1))
+        return cond
+
+    def index_expr(self):
+        """Return an array index that is always within bounds."""
+        return "((%s) %% %d + %d) %% %d" % (self.int_expr(self.expr_depth - 1), array_size, array_size, array_size)
+
+    def declare_locals(self, indent):
+        names = []
+        for i in range(self.locals_per_scope):
+            names.append("v%d" % self.next_local)
+            self.next_local += 1
+        if names:
+            self.emit(indent, "int %s;" % ", ".join(names))
+            for name in names:
+                self.emit(indent, "%s = %d;" % (name, self.random.randrange(100)))
+        self.scopes.append(names)
+
+    def block(self, indent, depth, method_index):
+        self.declare_locals(indent)
+        for i in range(self.statements):
+            self.statement(indent, depth, method_index)
+        self.scopes.pop()
+
+    def statement(self, indent, depth, method_index):
+        kinds = ["assign", "assign", "call"]
+        if self.arrays > 0:
+            kinds.append("array")
+        if depth > 0:
+            kinds.extend(["if", "while", "for"])
+        kind = self.random.choice(kinds)
+        targets = self.visible_locals()
+
+        if kind == "assign" and targets:
+            self.emit(indent, "%s = %s;" % (self.random.choice(targets), self.int_expr(self.expr_depth)))
+        elif kind == "array":
+            self.emit(indent, "g%d[%s] = %s;" % (self.random.randrange(self.arrays), self.index_expr(),
+                                                 self.int_expr(self.expr_depth)))
+        elif kind == "call" and method_index > 0:
+            # Only call earlier methods, so that the generated program terminates.
+            callee = self.random.randrange(method_index)
+            call = "m%d(%s, %s)" % (callee, self.int_expr(self.expr_depth - 1), self.int_expr(self.expr_depth - 1))
+            if targets:
+                self.emit(indent, "%s = %s;" % (self.random.choice(targets), call))
+            else:
+                self.emit(indent, "%s;" % call)
+        elif kind == "if":
+            self.emit(indent, "if (%s) {" % self.bool_expr(self.expr_depth))
+            self.block(indent + 1, depth - 1, method_index)
+            self.emit(indent, "} else {")
+            self.block(indent + 1, depth - 1, method_index)
+            self.emit(indent, "}")
+        elif kind in ["while", "for"]:
+            counter = "c%d" % self.next_local
+            self.next_local += 1
+            self.emit(indent, "{")
+            self.emit(indent + 1, "int %s;" % counter)
+            if kind == "for":
+                self.emit(indent + 1, "for (%s = 0; %s < %d; %s = %s + 1) {" % (counter, counter, loop_count, counter, counter))
+                self.block(indent + 2, depth - 1, method_index)
+            else:
+                self.emit(indent + 1, "%s = 0;" % counter)
+                self.emit(indent + 1, "while (%s < %d) {" % (counter, loop_count))
+                self.block(indent + 2, depth - 1, method_index)
+                self.emit(indent + 2, "%s = %s + 1;" % (counter, counter))
+            self.emit(indent + 1, "}")
+            self.emit(indent, "}")
+        elif targets:
+            self.emit(indent, "%s = %s;" % (self.random.choice(targets), self.int_expr(self.expr_depth)))
+
+    def method(self, index):
+        self.emit(1, "int m%d(int a, int b) {" % index)
+        self.scopes.append(["a", "b"])
+        self.block(2, self.depth, index)
+        self.emit(2, "return(%s);" % self.int_expr(self.expr_depth))
+        self.scopes.pop()
+        self.emit(1, "}")
+        self.emit(0, "")
+
+    def program(self):
+        self.emit(0, "extern void print_int(int);")
+        self.emit(0, "extern void print_string(string);")
+        self.emit(0, "")
+        self.emit(0, "class Synthetic {")
+        for i in range(self.arrays):
+            self.emit(1, "int g%d[%d];" % (i, array_size))
+        self.emit(0, "")
+        for i in range(self.methods):
+            self.method(i)
+        self.emit(1, "int main() {")
+        for i in range(self.methods):
+            self.emit(2, "print_int(m%d(%d, %d));" % (i, i, i + 1))
+            self.emit(2, "print_string(\"\\n\");")
+        self.emit(2, "return(0);")
+        self.emit(1, "}")
+        self.emit(0, "}")
+        return "\n".join(self.lines) + "\n"
+
+def generate(methods=default_methods, statements=default_statements, depth=default_depth,
+             locals_per_scope=default_locals, expr_depth=default_expr_depth, arrays=default_arrays, seed=default_seed):
+    """Return the source of a synthetic Decaf program of the provided size."""
+    return Generator(methods, statements, depth, locals_per_scope, expr_depth, arrays, seed).program()
+
+if __name__ == '__main__':
+    import getopt
+
+    options = { "-m": default_methods, "-s": default_statements, "-n": default_depth, "-l": default_locals,
+                "-x": default_expr_depth, "-a": default_arrays, "-r": default_seed }
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "m:s:n:l:x:a:r:")
+        for opt, value in opts:
+            options[opt] = int(value)
+        if len(args) > 1:
+            raise getopt.GetoptError("Too many arguments.")
+    except (getopt.GetoptError, ValueError):
+        sys.stderr.write(__doc__ % (sys.argv[0], default_methods, default_statements, default_depth, default_locals,
+                                    default_expr_depth, default_arrays, default_seed))
+        sys.exit(2)
+
+    source = generate(options["-m"], options["-s"], options["-n"], options["-l"], options["-x"], options["-a"],
+                      options["-r"])
+    if args:
+        with open(args[0], "w") as ostream:
+            ostream.write(source)
+    else:
+        sys.stdout.write(source)
@@ -0,0 +1,298 @@
+#!/usr/bin/env python
+
+"""
+usage: %s [options]
+
+Performance regression gate. Compiles and runs the q6-success programs
+(quicksort, catalan, gcd), scaled up variants of them and a large synthetic
+program, and records for each:
+
+compile_wall     fastest decaf-codegen wall time in seconds
+ir_instructions  IR instructions in the optimized module (-time-report=json)
+run_instructions user space instructions executed by the program (perf_event_open)
+run_cycles       user space cycles used by the program (perf_event_open)
+
+The results are compared with a stored baseline and the gate fails (exit
+status 1) if any metric grows by more than its threshold. Counter metrics are
+skipped, with a warning, when perf_event_open is not permitted.
+
+Options
+-c CODEGEN     path to the compiler codegen executable (default %s)
+-l STDLIB      path to the stdlib C file (default %s)
+-b BASELINE    baseline file (default %s)
+-u             write the results as the new baseline instead of checking them
+-f FLAGS       extra flags passed to CODEGEN, e.g. "-O2 -fbounds-check"
+-n REPEAT      compile and run every program REPEAT times, keeping the best (default %d)
+-t THRESHOLD   allowed growth of the deterministic metrics, in percent (default %g)
+-T THRESHOLD   allowed growth of the timing metrics, in percent (default %g)
+
+Environment variables:
+CC             C compiler for linking, defaults to gcc
+"""
+
+import ctypes
+import json
+import os
+import os.path
+import platform
+import re
+import shlex
+import shutil
+import signal
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+bench_dir = os.path.dirname(os.path.abspath(__file__))
+repo_dir = os.path.join(bench_dir, "..")
+testcase_dir = os.path.join(repo_dir, "testcases", "q6-success")
+
+default_codegen = os.path.join(repo_dir, "answer", "decaf-codegen")
+default_stdlib = os.path.join(repo_dir, "decaf-stdlib.c")
+default_baseline = os.path.join(bench_dir, "perf-baseline.json")
+default_repeat = 3
+default_threshold = 2.0
+default_time_threshold = 15.0
+cc = os.environ.get('CC') or 'gcc'
+
+deterministic_metrics = ["ir_instructions", "run_instructions"]
+timing_metrics = ["compile_wall", "run_cycles"]
+
+def load_decaf_gen():
+    """Import decaf-gen.py, whose name is not a valid module name."""
+    path = os.path.join(bench_dir, "decaf-gen.py")
+    try:
+        import importlib.util
+        spec = importlib.util.spec_from_file_location("decaf_gen", path)
+        module = importlib.util.module_from_spec(spec)
+        spec.loader.exec_module(module)
+        return module
+    except ImportError:
+        import imp
+        return imp.load_source("decaf_gen", path)
+
+def read_testcase(name):
+    with open(os.path.join(testcase_dir, name), "r") as istream:
+        return istream.read()
+
+def benchmarks():
+    """Return (name, source, input, runnable) for every benchmark program."""
+    quicksort = read_testcase("quicksort.decaf")
+    catalan = read_testcase("catalan.decaf")
+    gcd = read_testcase("gcd.decaf")
+    scaled_quicksort = re.sub(r"\blist\[100\]", "list[5000]", re.sub(r"\bsize = 100;", "size = 5000;", quicksort))
+    # Consecutive Fibonacci numbers take the most steps.
+    scaled_gcd = gcd.replace("int a = 10;", "int a = 1134903170;").replace("int b = 20;", "int b = 701408733;")
+    synthetic = load_decaf_gen().generate(methods=40)
+
+    return [
+        ("quicksort", quicksort, None, True),
+        ("quicksort-5000", scaled_quicksort, None, True),
+        ("catalan", catalan, read_testcase("catalan.in"), True),
+        ("catalan-10", catalan, "10\n", True),
+        ("gcd", gcd, None, True),
+        ("gcd-fibonacci", scaled_gcd, None, True),
+        # Generated methods may run for very long, only compile it.
+        ("synthetic-40", synthetic, None, False),
+    ]
+
+# perf_event_open(2) through ctypes. Only the first 64 bytes of perf_event_attr
+# (PERF_ATTR_SIZE_VER0) are needed.
+perf_syscalls = { "x86_64": 298, "i386": 336, "i686": 336, "aarch64": 241, "armv7l": 364, "ppc64le": 319 }
+PERF_TYPE_HARDWARE = 0
+PERF_COUNT_HW_CPU_CYCLES = 0
+PERF_COUNT_HW_INSTRUCTIONS = 1
+PERF_ATTR_SIZE_VER0 = 64
+PERF_FLAG_DISABLED = 1 << 0
+PERF_FLAG_INHERIT = 1 << 1
+PERF_FLAG_EXCLUDE_KERNEL = 1 << 5
+PERF_FLAG_EXCLUDE_HV = 1 << 6
+PERF_FLAG_ENABLE_ON_EXEC = 1 << 12
+
+libc = ctypes.CDLL(None, use_errno=True)
+
+def perf_event_open(config, pid):
+    """Open a disabled user space hardware counter of pid, which is enabled
+    when pid calls exec. Returns the file descriptor, or None if not permitted."""
+    number = perf_syscalls.get(platform.machine())
+    if number is None:
+        return None
+    flags = PERF_FLAG_DISABLED | PERF_FLAG_INHERIT | PERF_FLAG_EXCLUDE_KERNEL | PERF_FLAG_EXCLUDE_HV | PERF_FLAG_ENABLE_ON_EXEC
+    # type, size, config, sample_period, sample_type, read_format, flags, wakeup_events, bp_type, config1
+    attr = struct.pack("IIQQQQQIIQ", PERF_TYPE_HARDWARE, PERF_ATTR_SIZE_VER0, config, 0, 0, 0, flags, 0, 0, 0)
+    buffer = ctypes.create_string_buffer(attr, len(attr))
+    fd = libc.syscall(ctypes.c_long(number), buffer, ctypes.c_long(pid), ctypes.c_long(-1), ctypes.c_long(-1),
+                      ctypes.c_ulong(0))
+    return fd if fd >= 0 else None
+
+def read_counter(fd):
+    if fd is None:
+        return None
+    value = struct.unpack("Q", os.read(fd, 8))[0]
+    os.close(fd)
+    return value
+
+def run_counted(executable, input_path):
+    """Run the executable with its output discarded and return its status,
+    wall time, instruction count and cycle count. The child stops itself
+    before exec, so that the counters can be attached and only count the
+    program, from exec on."""
+    pid = os.fork()
+    if pid == 0:
+        try:
+            stdin = os.open(input_path or os.devnull, os.O_RDONLY)
+            stdout = os.open(os.devnull, os.O_WRONLY)
+            os.dup2(stdin, 0)
+            os.dup2(stdout, 1)
+            os.kill(os.getpid(), signal.SIGSTOP)
+            os.execv(executable, [executable])
+        finally:
+            os._exit(127)
+
+    os.waitpid(pid, os.WUNTRACED)
+    instructions = perf_event_open(PERF_COUNT_HW_INSTRUCTIONS, pid)
+    cycles = perf_event_open(PERF_COUNT_HW_CPU_CYCLES, pid)
+    start = time.time()
+    os.kill(pid, signal.SIGCONT)
+    status = os.waitpid(pid, 0)[1]
+    wall = time.time() - start
+
+    return os.WEXITSTATUS(status) if os.WIFEXITED(status) else -1, wall, read_counter(instructions), read_counter(cycles)
+
+def compile_program(codegen, flags, source_path, object_path):
+    """Compile the source to a native object, returning the wall time and the
+    JSON time report."""
+    cmd = [codegen, "-time-report=json", "-emit-obj", "-o", object_path] + flags
+    with open(source_path, "r") as istream:
+        start = time.time()
+        process = subprocess.Popen(cmd, stdin=istream, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        out, err = process.communicate()
+        wall = time.time() - start
+    err = err.decode("utf-8", "replace")
+    if process.returncode != 0:
+        sys.stderr.write(err)
+        raise RuntimeError("%s failed with status %d on %s" % (" ".join(cmd), process.returncode, source_path))
+
+    reports = [json.loads(line) for line in err.splitlines() if line.startswith("{")]
+    if not reports:
+        raise RuntimeError("%s printed no time report, was it built with -time-report support?" % codegen)
+    return wall, reports[-1]
+
+def measure(work_dir, codegen, stdlib, flags, repeat, name, source, input_text, runnable):
+    prefix = os.path.join(work_dir, name)
+    with open(prefix + ".decaf", "w") as ostream:
+        ostream.write(source)
+    input_path = None
+    if input_text is not None:
+        input_path = prefix + ".in"
+        with open(input_path, "w") as ostream:
+            ostream.write(input_text)
+
+    compiles = [compile_program(codegen, flags, prefix + ".decaf", prefix + ".o") for i in range(repeat)]
+    result = {
+        "compile_wall": min(wall for wall, report in compiles),
+        "ir_instructions": compiles[0][1]["instructions_after"],
+    }
+    if not runnable:
+        return result
+
+    subprocess.check_call([cc, "-o", prefix, prefix + ".o", stdlib])
+    runs = [run_counted(prefix, input_path) for i in range(repeat)]
+    for status, wall, instructions, cycles in runs:
+        if status != 0:
+            raise RuntimeError("%s exited with status %d" % (name, status))
+    if runs[0][2] is not None:
+        result["run_instructions"] = min(run[2] for run in runs)
+        result["run_cycles"] = min(run[3] for run in runs if run[3] is not None)
+    else:
+        sys.stderr.write("warning: perf_event_open is not available, %s has no counter metrics\n" % name)
+    return result
+
+def compare(results, baseline, threshold, time_threshold):
+    """Print every metric next to its baseline value, returning the regressions."""
+    regressions = []
+    sys.stdout.write("%-16s %-18s %14s %14s %9s\n" % ("benchmark", "metric", "baseline", "current", "change"))
+    for name in sorted(results):
+        for metric in deterministic_metrics + timing_metrics:
+            current = results[name].get(metric)
+            base = baseline.get(name, {}).get(metric)
+            if current is None or base is None:
+                continue
+            change = (100.0 * (current - base) / base) if base else 0.0
+            limit = threshold if metric in deterministic_metrics else time_threshold
+            flag = ""
+            if change > limit:
+                flag = " REGRESSED"
+                regressions.append((name, metric))
+            sys.stdout.write("%-16s %-18s %14g %14g %+8.1f%%%s\n" % (name, metric, base, current, change, flag))
+    return regressions
+
+if __name__ == '__main__':
+    import getopt
+
+    codegen = default_codegen
+    stdlib = default_stdlib
+    baseline_file = default_baseline
+    update = False
+    flags = []
+    repeat = default_repeat
+    threshold = default_threshold
+    time_threshold = default_time_threshold
+
+    try:
+        opts, args = getopt.getopt(sys.argv[1:], "c:l:b:uf:n:t:T:")
+        for opt, value in opts:
+            if opt == "-c":
+                codegen = value
+            elif opt == "-l":
+                stdlib = value
+            elif opt == "-b":
+                baseline_file = value
+            elif opt == "-u":
+                update = True
+            elif opt == "-f":
+                flags = shlex.split(value)
+            elif opt == "-n":
+                repeat = int(value)
+            elif opt == "-t":
+                threshold = float(value)
+            elif opt == "-T":
+                time_threshold = float(value)
+        if args or repeat < 1:
+            raise getopt.GetoptError("Invalid arguments.")
+    except (getopt.GetoptError, ValueError):
+        sys.stderr.write(__doc__ % (sys.argv[0], default_codegen, default_stdlib, default_baseline, default_repeat,
+                                    default_threshold, default_time_threshold))
+        sys.exit(2)
+
+    codegen = os.path.abspath(codegen)
+    work_dir = tempfile.mkdtemp(prefix="decaf-perf.")
+    try:
+        results = {}
+        for name, source, input_text, runnable in benchmarks():
+            results[name] = measure(work_dir, codegen, stdlib, flags, repeat, name, source, input_text, runnable)
+    finally:
+        shutil.rmtree(work_dir)
+
+    if update:
+        with open(baseline_file, "w") as ostream:
+            json.dump({ "flags": flags, "results": results }, ostream, indent=2, sort_keys=True)
+        sys.stdout.write("wrote baseline %s\n" % baseline_file)
+        sys.exit(0)
+
+    if not os.path.exists(baseline_file):
+        sys.stderr.write("no baseline %s, create one with -u\n" % baseline_file)
+        sys.exit(2)
+    with open(baseline_file, "r") as istream:
+        baseline = json.load(istream)
+    if baseline.get("flags") != flags:
+        sys.stderr.write("warning: baseline was recorded with flags %s\n" % baseline.get("flags"))
+
+    regressions = compare(results, baseline["results"], threshold, time_threshold)
+    if regressions:
+        sys.stdout.write("%d metric(s) regressed: %s\n" % (len(regressions),
+                         ", ".join("%s %s" % regression for regression in regressions)))
+        sys.exit(1)
+    sys.stdout.write("no regressions\n")
@@ -15,7 +15,13 @@ The specific TC.STAGE* files are:
 	TC.STAGE.ret	exist status from STAGE
 These intermediate files go in the -o output path if it is given. TC.llvm.ret and TC.run.out are checked against the corresponding files from the testcase.
 
+Each stage also writes TC.STAGE.time, and the total time of each stage is reported at the end. Unless -N is given, llvm-run compiles the stdlib once and replays a stage from the cache directory when its command and input files (source code, compiler binary, previous stage result) are unchanged; only the run stage always runs.
+
 The TC.{out,err,ret} files represent the compiling process as a whole, and are not checked. The compiling process is always considered to succeed unless there is an internal error, even if the code generation stage fails (ie TC.llvm.ret may contain a non-zero number, but TC.ret will contain zero).
+
+Options specific to this checker:
+	-C DIR	Cache directory for stage results and the compiled stdlib (default .llvm-run-cache in the checker directory).
+	-N	Disable the cache, run every stage of every testcase.
 """
 
 import check
@@ -29,6 +35,9 @@ codegen = "./decaf-codegen"
 source_extension = ".decaf"
 testcase_run = "llvm-run"
 stdlib = "decaf-stdlib.c"
+cache_dir = None
+use_cache = True
+default_cache_dir = ".llvm-run-cache"
 
 def testcase_prefix(testcases_path, group, testcase):
     return os.path.join(testcases_path, group, testcase)
@@ -43,7 +52,10 @@ def load_files(*paths):
 
 def command(**args):
     source_file = testcase_prefix(args['testcases_path'], args['group'], (args['testcase'])) + source_extension
-    return [os.path.join(args['check_dir'], testcase_run), "-c", codegen, "-l", stdlib, source_file, args['log_dir'], args['group'], args['testcase']]
+    run_options = []
+    if use_cache:
+        run_options = ["-C", cache_dir or os.path.join(args['check_dir'], default_cache_dir)]
+    return [os.path.join(args['check_dir'], testcase_run)] + run_options + ["-c", codegen, "-l", stdlib, source_file, args['log_dir'], args['group'], args['testcase']]
 
 def diff_exact(a, b, output):
     if a != b:
@@ -99,4 +111,12 @@ check_defaults = {
         'file_checks': [make_file_check_llvm_err, make_file_check_run_out]
     } 
 
-check.check_all(checks, check_defaults, extra_usage=__doc__.rstrip('\n\r') % (source_extension))
+def parse_options(opts):
+    global cache_dir, use_cache
+    for opt, value in opts:
+        if opt == "-C":
+            cache_dir = os.path.abspath(value)
+        elif opt == "-N":
+            use_cache = False
+
+check.check_all(checks, check_defaults, extra_ops=("C:N", parse_options), extra_usage=__doc__.rstrip('\n\r') % (source_extension))
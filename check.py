@@ -8,6 +8,7 @@ Options:
 	-B	Disable backups of existing extra files produced by during checking. If set then the existing files will be overwritten without confirmation.
 	-o DIR	Save the output from the testcases to DIR. Will overwrite existing files in DIR. Useful for debugging your code. DIR will always contain the output and exit status of the processes executed during checks. It may also contain extra intermediate files.
 	-d	Show a comparison of outputs in a diff-like format for each failed testcase. For testcases where output is not matched exactly, the diff will show a comparison where the output and expected output are in a normalized form. Read the diff functions (listed at the end of the usage output) if the diff is not clear.
+	-j N	Run N testcases at a time (default 1). The output of each testcase is still reported in order. Only use this when every testcase writes its files to its own log directory path, as the llvm-run based checkers do.
 	-s FILE	Skip all testcases indicated by FILE. Each line in FILE is either a group name, in which case all testcases for that group will be skipped; or a group name and a testcase name, in which case the specific testcase will be skipped for that group.
 """
 
@@ -22,6 +23,9 @@ import shlex
 import pipes
 import pprint
 import operator
+import itertools
+import StringIO
+from multiprocessing.pool import ThreadPool
 
 class SourceNotFound(Exception):
   def __init__(self, missing_files):
@@ -180,7 +184,7 @@ def backup_files(dir, *paths):
             os.rename(path, temp_path)
             assert not os.path.exists(path)
 
-def run_testcase(testcases_path, group, testcase, checks, check_defaults, log_dir, do_backups=True, output_path=None, diff_output=None, check_dir=None):
+def run_testcase(testcases_path, group, testcase, checks, check_defaults, log_dir, do_backups=True, output_path=None, diff_output=None, check_dir=None, report=sys.stdout):
     check = expand_all(checks, check_defaults, group, testcase, testcases_path, log_dir, check_dir)[group]
     command = list(check['command'])
     source_files = check['source_files']
@@ -241,12 +245,12 @@ def run_testcase(testcases_path, group, testcase, checks, check_defaults, log_di
                 if 'name' in file_check:
                     msg = "%s (%s)" % (msg, file_check['name'])
                 failed.append(msg)
-        print >> sys.stdout, group, testcase, ":",
+        print >> report, group, testcase, ":",
         if len(failed) > 0:
-            print >> sys.stdout, "failed : %s" % (', '.join(failed))
+            print >> report, "failed : %s" % (', '.join(failed))
             return False
         else:
-            print >> sys.stdout, "passed"
+            print >> report, "passed"
             return True
     except Exception:
         if input_file is not None:
@@ -254,14 +258,56 @@ def run_testcase(testcases_path, group, testcase, checks, check_defaults, log_di
             print >> sys.stderr
         raise
 
-def run_testcases(path, checks, check_defaults, do_backups=True, output_path=None, diff_output=None, skip=set(), log_dir=None, check_dir=None):
+def print_stage_times(log_dir, testcases):
+    """
+    Prints the total wall time of each stage over the testcases, for commands that
+    record it in LOG-DIR/GROUP/TESTCASE.STAGE.time files ("seconds ran|cached").
+    """
+    totals = collections.OrderedDict()
+    for group, testcase in testcases:
+        group_dir = os.path.join(log_dir, group)
+        prefix = testcase + "."
+        if not os.path.isdir(group_dir):
+            continue
+        for f in sorted(os.listdir(group_dir)):
+            if f.startswith(prefix) and f.endswith(".time"):
+                stage = f[len(prefix):-len(".time")]
+                with open(os.path.join(group_dir, f)) as file:
+                    fields = file.read().split()
+                seconds, runs, cached = totals.get(stage, (0.0, 0, 0))
+                totals[stage] = (seconds + float(fields[0]), runs + 1, cached + int(fields[1] == "cached"))
+    if len(totals) > 0:
+        print >> sys.stderr, "stage times:"
+        for stage, (seconds, runs, cached) in totals.items():
+            print >> sys.stderr, "\t%s : %.3fs over %i runs (%i cached)" % (stage, seconds, runs, cached)
+
+def run_testcases(path, checks, check_defaults, do_backups=True, output_path=None, diff_output=None, skip=set(), log_dir=None, check_dir=None, jobs=1):
     counts = {}
     no_program = set()
     temp_log_dir = log_dir is None
     if temp_log_dir:
         log_dir = tempfile.mkdtemp()
 
+    def run_one(group_testcase):
+        """
+        Runs a testcase, returning whether it passed, the source files it was
+        missing, if any, and its report when it had to be buffered.
+        """
+        group, testcase = group_testcase
+        report = StringIO.StringIO() if jobs > 1 else sys.stdout
+        testcase_diff_output = report if jobs > 1 and diff_output is not None else diff_output
+        missing_files = None
+        try:
+            output = os.path.join(output_path, group, testcase) if output_path is not None else None
+            passed = run_testcase(path, group, testcase, checks, check_defaults, log_dir, do_backups=do_backups, output_path=output, diff_output=testcase_diff_output, check_dir=check_dir, report=report)
+        except SourceNotFound as e:
+            missing_files = e.missing_files
+            passed = False
+        return passed, missing_files, report.getvalue() if jobs > 1 else ""
+
+    pool = ThreadPool(jobs) if jobs > 1 else None
     try:
+        queued = []
         for group in sorted(checks.iterkeys()):
             counts.setdefault(group, (0, 0))
             subdir_path = os.path.join(path, group)
@@ -271,18 +317,24 @@ def run_testcases(path, checks, check_defaults, do_backups=True, output_path=Non
                     if (group,) in skip or (group, testcase) in skip:
                         print >> sys.stderr, "warning: skipping %s %s by manual choice" % (group, testcase)
                     else:
-                        try:
-                            output = os.path.join(output_path, group, testcase) if output_path is not None else None
-                            passed = run_testcase(path, group, testcase, checks, check_defaults, log_dir, do_backups=do_backups, output_path=output, diff_output=diff_output, check_dir=check_dir)
-                        except SourceNotFound as e:
-                            print >> sys.stderr, "warning: skipping %s because the following source file%s not exist: %s" % (group, " does" if len(e.missing_files) == 1 else "s do", ', '.join(e.missing_files))
-                            no_program.add(group)
-                            passed = False
-                        correct, total = counts.get(group)
-                        counts[group] = (correct + int(passed), total + 1)
+                        queued.append((group, testcase))
             else:
                 print >> sys.stderr, "warning: no testcases for %s" % (group)
+
+        # Testcases run concurrently, results are collected in the original order.
+        results = pool.imap(run_one, queued) if pool is not None else itertools.imap(run_one, queued)
+        for (group, testcase), (passed, missing_files, report) in itertools.izip(queued, results):
+            sys.stdout.write(report)
+            if missing_files is not None:
+                print >> sys.stderr, "warning: skipping %s because the following source file%s not exist: %s" % (group, " does" if len(missing_files) == 1 else "s do", ', '.join(missing_files))
+                no_program.add(group)
+            correct, total = counts.get(group)
+            counts[group] = (correct + int(passed), total + 1)
+        print_stage_times(log_dir, queued)
     finally:
+        if pool is not None:
+            pool.close()
+            pool.join()
         if temp_log_dir:
             shutil.rmtree(log_dir)
 
@@ -337,7 +389,7 @@ def check_all(checks, check_defaults=default_check_defaults(), argv=sys.argv, ex
     check_dir = os.path.dirname(os.path.abspath(sys.argv[0]))
 
     try:
-        opt_spec = "Bo:ds:"
+        opt_spec = "Bo:ds:j:"
         if extra_ops is not None:
             opt_spec += extra_ops[0]
         opts, args = getopt.getopt(argv[1:], opt_spec)
@@ -345,6 +397,7 @@ def check_all(checks, check_defaults=default_check_defaults(), argv=sys.argv, ex
         output_path = None
         diff_output = None
         skip = set()
+        jobs = 1
         for opt, value in opts:
             if opt == "-B":
                 do_backups = False
@@ -352,6 +405,10 @@ def check_all(checks, check_defaults=default_check_defaults(), argv=sys.argv, ex
                 output_path = os.path.abspath(value)
             elif opt == "-d":
                 diff_output = sys.stdout
+            elif opt == "-j":
+                jobs = int(value)
+                if jobs < 1:
+                    raise getopt.GetoptError("Invalid number of jobs.")
             elif opt == "-s":
                 with open(value) as file:
                     skip = set(tuple(line.split()) for line in file)
@@ -359,7 +416,7 @@ def check_all(checks, check_defaults=default_check_defaults(), argv=sys.argv, ex
             extra_ops[1](opts)
         if len(args) < 2:
             raise getopt.GetoptError("Not enough arguments.")
-    except getopt.GetoptError, e:
+    except (getopt.GetoptError, ValueError), e:
         usage(sys.argv[0], checks, check_defaults, check_dir, extra=extra_usage)
         sys.exit(1)
 
@@ -368,7 +425,7 @@ def check_all(checks, check_defaults=default_check_defaults(), argv=sys.argv, ex
     os.chdir(answer_dir)
 
     for testcase_path in testcase_paths:
-        counts, no_program = run_testcases(testcase_path, checks, check_defaults, do_backups=do_backups, output_path=output_path, diff_output=diff_output, skip=skip, log_dir=output_path, check_dir=check_dir)
+        counts, no_program = run_testcases(testcase_path, checks, check_defaults, do_backups=do_backups, output_path=output_path, diff_output=diff_output, skip=skip, log_dir=output_path, check_dir=check_dir, jobs=jobs)
         for program, (correct, total) in counts.iteritems():
             print "%s : %i / %i%s" % (program, correct, total, " (missing source)" if program in no_program else "")
         print "total : %i / %i" % (sum(c for (c, t) in counts.itervalues()), sum(t for (c, t) in counts.itervalues()))
@@ -1,17 +1,445 @@
 
-#include <stdio.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Output is collected in a large buffer and written when it is full, before
+   input is read, and when the program exits (or dies on a trap). Input is
+   parsed from the memory mapped stdin when it is a regular file, and from
+   large block reads otherwise. Neither path uses stdio. */
+
+#define OUTPUT_BUFFER_SIZE 65536
+#define INPUT_BUFFER_SIZE 65536
+#define INT_DIGITS 12
+#define COUNT_DIGITS 20
+#define REPORT_BUFFER_SIZE 4096
+#define MAX_METHOD_FRAMES 65536
+#define CALL_EDGE_TABLE_SIZE 4096
+
+static char output_buffer[OUTPUT_BUFFER_SIZE];
+static size_t output_length = 0;
+static int runtime_initialized = 0;
+
+static char input_block[INPUT_BUFFER_SIZE];
+static const char *input_pos = NULL;
+static const char *input_end = NULL;
+static int input_mapped = 0;
+static int input_eof = 0;
+
+static void write_all(int fd, const char *data, size_t length) {
+  while (length > 0) {
+    ssize_t written = write(fd, data, length);
+    if (written <= 0) {
+      return;
+    }
+    data += written;
+    length -= written;
+  }
+}
+
+void flush_output() {
+  write_all(STDOUT_FILENO, output_buffer, output_length);
+  output_length = 0;
+}
+
+static void flush_on_signal(int signal_number) {
+  /* write is async signal safe, so the output so far survives a trap. */
+  flush_output();
+  signal(signal_number, SIG_DFL);
+  raise(signal_number);
+}
+
+static void initialize_runtime() {
+  runtime_initialized = 1;
+  atexit(flush_output);
+  signal(SIGILL, flush_on_signal);
+  signal(SIGTRAP, flush_on_signal);
+  signal(SIGFPE, flush_on_signal);
+  signal(SIGSEGV, flush_on_signal);
+}
+
+static void append_output(const char *data, size_t length) {
+  if (!runtime_initialized) {
+    initialize_runtime();
+  }
+  if (output_length + length > OUTPUT_BUFFER_SIZE) {
+    flush_output();
+    if (length > OUTPUT_BUFFER_SIZE) {
+      write_all(STDOUT_FILENO, data, length);
+      return;
+    }
+  }
+  memcpy(output_buffer + output_length, data, length);
+  output_length += length;
+}
+
+/* Format the digits of the value so that they end at end, returning their start. */
+static char *format_unsigned(char *end, unsigned long long value) {
+  do {
+    *--end = '0' + value % 10;
+    value /= 10;
+  } while (value != 0);
+  return end;
+}
 
 void print_int(int x) {
-  printf("%d", x);
+  char digits[INT_DIGITS];
+  /* Negate as unsigned, so that INT_MIN is formatted correctly. */
+  char *start = format_unsigned(digits + INT_DIGITS, x < 0 ? 0u - (unsigned int) x : (unsigned int) x);
+
+  if (x < 0) {
+    *--start = '-';
+  }
+
+  append_output(start, digits + INT_DIGITS - start);
 }
 
 void print_string(const char *s) {
-  printf("%s", s);
+  append_output(s, strlen(s));
+}
+
+/* print_string of a string constant, whose length the compiler knows. */
+void decaf_print_string(const char *s, int length) {
+  append_output(s, length);
+}
+
+/* Make more input available, returning 0 at the end of the input. */
+static int fill_input() {
+  struct stat info;
+  ssize_t length;
+
+  if (input_eof) {
+    return 0;
+  }
+
+  if (input_pos == NULL && fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+    if (mapped != MAP_FAILED) {
+      input_mapped = 1;
+      input_pos = (const char *) mapped;
+      input_end = input_pos + info.st_size;
+      return 1;
+    }
+  }
+  if (input_mapped) {
+    input_eof = 1;
+    return 0;
+  }
+
+  /* Prompts written so far must be visible before blocking on input. */
+  flush_output();
+  length = read(STDIN_FILENO, input_block, INPUT_BUFFER_SIZE);
+  if (length <= 0) {
+    input_eof = 1;
+    return 0;
+  }
+  input_pos = input_block;
+  input_end = input_block + length;
+  return 1;
+}
+
+/* Return the next input character without consuming it, or -1 at the end of the input. */
+static int peek_input() {
+  if (input_pos == input_end && !fill_input()) {
+    return -1;
+  }
+  return (unsigned char) *input_pos;
 }
 
 int read_int() {
-  int i;
-  scanf("%d", &i);
-  return i;
+  unsigned int value = 0;
+  int negative = 0;
+  int c = peek_input();
+
+  while (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f') {
+    input_pos++;
+    c = peek_input();
+  }
+  if (c == '-' || c == '+') {
+    negative = (c == '-');
+    input_pos++;
+    c = peek_input();
+  }
+  while (c >= '0' && c <= '9') {
+    value = value * 10 + (c - '0');
+    input_pos++;
+    c = peek_input();
+  }
+
+  return (int) (negative ? 0u - value : value);
+}
+
+/* Counters of a method compiled with -fprofile-generate: its entry count, then
+   the true and false edge counts of each of its conditional branches. */
+struct decaf_profile_entry {
+  const char *name;
+  int num_counters;
+  unsigned long long *counters;
+};
+
+static const struct decaf_profile_entry *profile_table = NULL;
+static int profile_size = 0;
+static const char *profile_path = NULL;
+
+/* Reports written at exit (profiles) are buffered like the output, on their own
+   file descriptor. */
+static char report_buffer[REPORT_BUFFER_SIZE];
+static size_t report_length = 0;
+
+static void flush_report(int fd) {
+  write_all(fd, report_buffer, report_length);
+  report_length = 0;
 }
 
+static void append_report(int fd, const char *data, size_t length) {
+  if (report_length + length > REPORT_BUFFER_SIZE) {
+    flush_report(fd);
+    if (length > REPORT_BUFFER_SIZE) {
+      write_all(fd, data, length);
+      return;
+    }
+  }
+  memcpy(report_buffer + report_length, data, length);
+  report_length += length;
+}
+
+static void append_report_string(int fd, const char *s) {
+  append_report(fd, s, strlen(s));
+}
+
+/* Append the count right aligned in a column of the width (at least one space). */
+static void append_report_count(int fd, unsigned long long count, int width) {
+  char digits[COUNT_DIGITS + 1];
+  char *end = digits + COUNT_DIGITS + 1;
+  char *start = format_unsigned(end, count);
+
+  do {
+    *--start = ' ';
+  } while (end - start < width && start > digits);
+  append_report(fd, start, end - start);
+}
+
+/* Write the counts of every method, one "NAME COUNT C0 C1 ..." line each. */
+static void write_profile() {
+  int fd = open(profile_path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  int i, j;
+
+  if (fd < 0) {
+    return;
+  }
+  append_report_string(fd, "decaf-profile 1\n");
+  for (i = 0; i < profile_size; i++) {
+    const struct decaf_profile_entry *entry = &profile_table[i];
+    append_report_string(fd, entry->name);
+    append_report_count(fd, entry->num_counters, 0);
+    for (j = 0; j < entry->num_counters; j++) {
+      append_report_count(fd, entry->counters[j], 0);
+    }
+    append_report_string(fd, "\n");
+  }
+  flush_report(fd);
+  close(fd);
+}
+
+/* Called on entry to main by programs compiled with -fprofile-generate, the
+   counts are written to the path when the program exits. */
+void decaf_profile_start(const struct decaf_profile_entry *table, int size, const char *path) {
+  profile_table = table;
+  profile_size = size;
+  profile_path = path;
+  atexit(write_profile);
+}
+
+/* Counts of a method compiled with -finstrument-methods. Cycles are inclusive
+   of callees (counted once for recursive calls) or exclusive of them. Records
+   are linked into method_records when the method is first entered. */
+struct decaf_method_record {
+  unsigned long long calls;
+  unsigned long long inclusive_cycles;
+  unsigned long long exclusive_cycles;
+  struct decaf_method_record *next;
+  int active;
+  char name[];
+};
+
+struct method_frame {
+  struct decaf_method_record *record;
+  unsigned long long start;
+  unsigned long long callee_cycles;
+};
+
+struct call_edge {
+  struct decaf_method_record *caller;
+  struct decaf_method_record *callee;
+  unsigned long long calls;
+  unsigned long long cycles;
+};
+
+static struct decaf_method_record *method_records = NULL;
+static int method_count = 0;
+static struct method_frame method_frames[MAX_METHOD_FRAMES];
+static int method_depth = 0;
+static struct call_edge call_edges[CALL_EDGE_TABLE_SIZE];
+static int call_edge_count = 0;
+static unsigned long long dropped_calls = 0;
+
+static unsigned long long read_cycles() {
+#if defined(__i386__) || defined(__x86_64__)
+  unsigned int low, high;
+  __asm__ __volatile__("rdtsc" : "=a"(low), "=d"(high));
+  return ((unsigned long long) high << 32) | low;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+/* Add a call from the caller to the callee to the call graph, an open addressed
+   table. Calls are only counted as dropped once the table is full. */
+static void add_call_edge(struct decaf_method_record *caller, struct decaf_method_record *callee,
+                          unsigned long long cycles) {
+  size_t slot = (((size_t) caller >> 4) * 31 + ((size_t) callee >> 4)) & (CALL_EDGE_TABLE_SIZE - 1);
+  struct call_edge *edge;
+
+  while (1) {
+    edge = &call_edges[slot];
+    if (edge->caller == caller && edge->callee == callee) {
+      break;
+    } else if (edge->caller == NULL) {
+      if (call_edge_count == CALL_EDGE_TABLE_SIZE - 1) {
+        dropped_calls++;
+        return;
+      }
+      call_edge_count++;
+      edge->caller = caller;
+      edge->callee = callee;
+      break;
+    }
+    slot = (slot + 1) & (CALL_EDGE_TABLE_SIZE - 1);
+  }
+  edge->calls++;
+  edge->cycles += cycles;
+}
+
+static int compare_exclusive_cycles(const void *first, const void *second) {
+  const struct decaf_method_record *a = *(struct decaf_method_record *const *) first;
+  const struct decaf_method_record *b = *(struct decaf_method_record *const *) second;
+  return (a->exclusive_cycles < b->exclusive_cycles) - (a->exclusive_cycles > b->exclusive_cycles);
+}
+
+/* Print the flat profile, methods by decreasing exclusive cycles, then the call
+   graph: the callers and callees of each method with their calls and cycles. */
+static void write_method_profile() {
+  struct decaf_method_record **records = malloc(method_count * sizeof(struct decaf_method_record *));
+  struct decaf_method_record *record;
+  unsigned long long total = 0;
+  int fd = STDERR_FILENO;
+  int i, j;
+
+  if (records == NULL) {
+    return;
+  }
+  for (i = 0, record = method_records; record != NULL; record = record->next) {
+    records[i++] = record;
+    total += record->exclusive_cycles;
+  }
+  qsort(records, method_count, sizeof(struct decaf_method_record *), compare_exclusive_cycles);
+
+  append_report_string(fd, "\nFlat profile (cycles)\n  %excl        exclusive        inclusive        calls  method\n");
+  for (i = 0; i < method_count; i++) {
+    record = records[i];
+    append_report_count(fd, total == 0 ? 0 : record->exclusive_cycles * 100 / total, 7);
+    append_report_count(fd, record->exclusive_cycles, 17);
+    append_report_count(fd, record->inclusive_cycles, 17);
+    append_report_count(fd, record->calls, 13);
+    append_report_string(fd, "  ");
+    append_report_string(fd, record->name);
+    append_report_string(fd, "\n");
+  }
+
+  append_report_string(fd, "\nCall graph (cycles include the callees)\n");
+  for (i = 0; i < method_count; i++) {
+    record = records[i];
+    append_report_string(fd, record->name);
+    append_report_string(fd, "\n");
+    for (j = 0; j < CALL_EDGE_TABLE_SIZE; j++) {
+      if (call_edges[j].callee == record) {
+        append_report_string(fd, "    from ");
+        append_report_string(fd, call_edges[j].caller->name);
+        append_report_count(fd, call_edges[j].calls, 13);
+        append_report_string(fd, " calls");
+        append_report_count(fd, call_edges[j].cycles, 17);
+        append_report_string(fd, " cycles\n");
+      }
+    }
+    for (j = 0; j < CALL_EDGE_TABLE_SIZE; j++) {
+      if (call_edges[j].caller == record) {
+        append_report_string(fd, "    to ");
+        append_report_string(fd, call_edges[j].callee->name);
+        append_report_count(fd, call_edges[j].calls, 13);
+        append_report_string(fd, " calls");
+        append_report_count(fd, call_edges[j].cycles, 17);
+        append_report_string(fd, " cycles\n");
+      }
+    }
+  }
+  if (dropped_calls > 0) {
+    append_report_string(fd, "Calls missing from the call graph (table full):");
+    append_report_count(fd, dropped_calls, 0);
+    append_report_string(fd, "\n");
+  }
+  flush_report(fd);
+  free(records);
+}
+
+/* Called on entry to every method of programs compiled with -finstrument-methods. */
+void decaf_method_enter(struct decaf_method_record *record) {
+  unsigned long long now = read_cycles();
+
+  if (record->calls++ == 0) {
+    if (method_records == NULL) {
+      atexit(write_method_profile);
+    }
+    record->next = method_records;
+    method_records = record;
+    method_count++;
+  }
+  record->active++;
+  /* Calls nested deeper than the frames are only counted. */
+  if (method_depth < MAX_METHOD_FRAMES) {
+    method_frames[method_depth].record = record;
+    method_frames[method_depth].callee_cycles = 0;
+    method_frames[method_depth].start = now;
+  }
+  method_depth++;
+}
+
+/* Called before every return of methods compiled with -finstrument-methods. */
+void decaf_method_exit(struct decaf_method_record *record) {
+  unsigned long long now = read_cycles();
+  struct method_frame *frame;
+  unsigned long long cycles;
+
+  record->active--;
+  method_depth--;
+  if (method_depth >= MAX_METHOD_FRAMES) {
+    return;
+  }
+
+  frame = &method_frames[method_depth];
+  cycles = now - frame->start;
+  record->exclusive_cycles += cycles - frame->callee_cycles;
+  if (record->active == 0) {
+    record->inclusive_cycles += cycles;
+  }
+  if (method_depth > 0) {
+    method_frames[method_depth - 1].callee_cycles += cycles;
+    add_call_edge(method_frames[method_depth - 1].record, record, cycles);
+  }
+}